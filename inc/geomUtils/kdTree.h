@@ -0,0 +1,276 @@
+// A static KD-tree over n-dimensional points for nearest neighbour and
+// radius queries
+#ifndef _KD_TREE_H_
+#define _KD_TREE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "geomUtils/point.h"
+#include "utils/functionHelpers.h"
+
+// The tree has no nodes or child pointers. The points are reordered so that
+// the subtree over positions [begin, end) splits at its median position
+// mid = begin + (end - begin) / 2: the points of [begin, mid) are not above
+// the point at mid along its split axis and those of (mid, end) are not
+// below it. Ranges of at most c_leafSize points are leaves, scanned linearly.
+// Each point is stored packed with its input index, so a query reads
+// contiguous memory near the leaves. The tree is built level by level, with
+// the subtrees of a level split on worker threads.
+template <class T, size_t N>
+class KdTree {
+ public:
+  typedef Point<T, N> PointType;
+  typedef uint32_t IndexType;
+
+  struct Neighbour {
+    IndexType index;  // Into the points the tree was built from
+    T distance2;
+  };
+
+ private:
+  struct Entry {
+    std::array<T, N> point;
+    IndexType index;
+  };
+
+  std::vector<Entry> m_entries;
+  std::vector<uint8_t> m_splitAxes;  // At the mid position of each subtree
+
+  static constexpr size_t c_leafSize = 8;
+
+  static T distance2(const std::array<T, N>& point, const PointType& query) {
+    T sum = 0;
+    for (size_t axis = 0; axis < N; ++axis) {
+      T difference = point[axis] - query[axis];
+      sum += difference * difference;
+    }
+    return sum;
+  }
+
+  // By distance, then index; the front of a heap under this order is the
+  // neighbour to drop
+  static bool closer(const Neighbour& a, const Neighbour& b) {
+    return a.distance2 < b.distance2 ||
+           (a.distance2 == b.distance2 && a.index < b.index);
+  }
+
+  // Split [begin, end) at its median along its widest axis; returns mid
+  size_t split(size_t begin, size_t end) {
+    std::array<T, N> low = m_entries[begin].point;
+    std::array<T, N> high = low;
+    for (size_t i = begin + 1; i < end; ++i) {
+      for (size_t axis = 0; axis < N; ++axis) {
+        low[axis] = std::min(low[axis], m_entries[i].point[axis]);
+        high[axis] = std::max(high[axis], m_entries[i].point[axis]);
+      }
+    }
+    size_t widest = 0;
+    for (size_t axis = 1; axis < N; ++axis) {
+      if (high[axis] - low[axis] > high[widest] - low[widest]) {
+        widest = axis;
+      }
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(m_entries.begin() + begin, m_entries.begin() + mid,
+                     m_entries.begin() + end,
+                     [widest](const Entry& a, const Entry& b) {
+                       return a.point[widest] < b.point[widest];
+                     });
+    m_splitAxes[mid] = static_cast<uint8_t>(widest);
+    return mid;
+  }
+
+  void buildSubtree(size_t begin, size_t end) {
+    while (end - begin > c_leafSize) {
+      size_t mid = split(begin, end);
+      buildSubtree(begin, mid);
+      begin = mid + 1;
+    }
+  }
+
+  // Offer the point at position i to the k best in heap
+  void offer(size_t i, const PointType& query, size_t k,
+             std::vector<Neighbour>& heap) const {
+    Neighbour candidate = {m_entries[i].index,
+                           distance2(m_entries[i].point, query)};
+    if (heap.size() < k) {
+      heap.push_back(candidate);
+      std::push_heap(heap.begin(), heap.end(), closer);
+    } else if (closer(candidate, heap.front())) {
+      std::pop_heap(heap.begin(), heap.end(), closer);
+      heap.back() = candidate;
+      std::push_heap(heap.begin(), heap.end(), closer);
+    }
+  }
+
+  void kNearest(size_t begin, size_t end, const PointType& query, size_t k,
+                std::vector<Neighbour>& heap) const {
+    while (end - begin > c_leafSize) {
+      size_t mid = begin + (end - begin) / 2;
+      size_t axis = m_splitAxes[mid];
+      T offset = query[axis] - m_entries[mid].point[axis];
+      offer(mid, query, k, heap);
+      // Descend into the side of the query first; the other side only
+      // matters if the splitting plane is closer than the worst of the best
+      size_t nearBegin = offset < 0 ? begin : mid + 1;
+      size_t nearEnd = offset < 0 ? mid : end;
+      kNearest(nearBegin, nearEnd, query, k, heap);
+      if (heap.size() == k && offset * offset > heap.front().distance2) {
+        return;
+      }
+      begin = offset < 0 ? mid + 1 : begin;
+      end = offset < 0 ? end : mid;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      offer(i, query, k, heap);
+    }
+  }
+
+  void radiusSearch(size_t begin, size_t end, const PointType& query,
+                    T radius2, std::vector<Neighbour>& neighbours) const {
+    while (end - begin > c_leafSize) {
+      size_t mid = begin + (end - begin) / 2;
+      size_t axis = m_splitAxes[mid];
+      T offset = query[axis] - m_entries[mid].point[axis];
+      T midDistance2 = distance2(m_entries[mid].point, query);
+      if (midDistance2 <= radius2) {
+        neighbours.push_back(Neighbour{m_entries[mid].index, midDistance2});
+      }
+      if (offset <= 0 || offset * offset <= radius2) {
+        radiusSearch(begin, mid, query, radius2, neighbours);
+      }
+      if (offset < 0 && offset * offset > radius2) {
+        return;
+      }
+      begin = mid + 1;
+    }
+    for (size_t i = begin; i < end; ++i) {
+      T pointDistance2 = distance2(m_entries[i].point, query);
+      if (pointDistance2 <= radius2) {
+        neighbours.push_back(Neighbour{m_entries[i].index, pointDistance2});
+      }
+    }
+  }
+
+ public:
+  KdTree() {}
+
+  explicit KdTree(const std::vector<PointType>& points)
+      : m_entries(points.size()), m_splitAxes(points.size(), 0) {
+    assert(points.size() <= std::numeric_limits<IndexType>::max());
+    parallelFor<size_t>(0, points.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        for (size_t axis = 0; axis < N; ++axis) {
+          m_entries[i].point[axis] = points[i][axis];
+        }
+        m_entries[i].index = static_cast<IndexType>(i);
+      }
+    });
+
+    // Split level by level until there are enough subtrees to keep every
+    // worker busy, then build those independently
+    const size_t numSubtrees = 4 * numWorkerThreads();
+    std::vector<std::pair<size_t, size_t>> ranges(
+        1, std::make_pair(size_t(0), points.size()));
+    while (ranges.size() < numSubtrees) {
+      std::vector<std::pair<size_t, size_t>> children(2 * ranges.size());
+      parallelFor<size_t>(0, ranges.size(), [&](size_t first, size_t last) {
+        for (size_t range = first; range < last; ++range) {
+          size_t begin = ranges[range].first;
+          size_t end = ranges[range].second;
+          if (end - begin <= c_leafSize) {
+            children[2 * range] = ranges[range];
+            continue;
+          }
+          size_t mid = split(begin, end);
+          children[2 * range] = std::make_pair(begin, mid);
+          children[2 * range + 1] = std::make_pair(mid + 1, end);
+        }
+      }, 1);
+      size_t numRanges = ranges.size();
+      ranges.clear();
+      for (const std::pair<size_t, size_t>& child : children) {
+        if (child.second > child.first) {
+          ranges.push_back(child);
+        }
+      }
+      if (ranges.size() == numRanges) {
+        break;  // Only leaves left
+      }
+    }
+    parallelFor<size_t>(0, ranges.size(), [&](size_t first, size_t last) {
+      for (size_t range = first; range < last; ++range) {
+        buildSubtree(ranges[range].first, ranges[range].second);
+      }
+    }, 1);
+  }
+
+  size_t size() const throw() { return m_entries.size(); }
+  bool empty() const throw() { return m_entries.empty(); }
+
+  // The min(k, size()) points closest to query, nearest first. Ties go to
+  // the lower index
+  void kNearest(const PointType& query, size_t k,
+                std::vector<Neighbour>& neighbours) const {
+    neighbours.clear();
+    k = std::min(k, size());
+    if (k == 0) {
+      return;
+    }
+    neighbours.reserve(k);
+    kNearest(0, size(), query, k, neighbours);
+    std::sort_heap(neighbours.begin(), neighbours.end(), closer);
+  }
+
+  Neighbour nearest(const PointType& query) const {
+    assert(!empty());
+    std::vector<Neighbour> neighbours;
+    kNearest(query, 1, neighbours);
+    return neighbours.front();
+  }
+
+  // All points within radius of query, in no particular order
+  void radiusSearch(const PointType& query, T radius,
+                    std::vector<Neighbour>& neighbours) const {
+    neighbours.clear();
+    if (!empty()) {
+      radiusSearch(0, size(), query, radius * radius, neighbours);
+    }
+  }
+
+  // neighbours[i * k' + j] = j-th nearest point to queries[i], where
+  // k' = min(k, size()); queries in parallel
+  void kNearest(const std::vector<PointType>& queries, size_t k,
+                std::vector<Neighbour>& neighbours) const {
+    k = std::min(k, size());
+    neighbours.resize(queries.size() * k);
+    parallelFor<size_t>(0, queries.size(), [&](size_t begin, size_t end) {
+      std::vector<Neighbour> heap;
+      for (size_t query = begin; query < end; ++query) {
+        kNearest(queries[query], k, heap);
+        std::copy(heap.begin(), heap.end(), neighbours.begin() + query * k);
+      }
+    }, 64);
+  }
+
+  // neighbours[i] = radiusSearch of queries[i]; queries in parallel
+  void radiusSearch(const std::vector<PointType>& queries, T radius,
+                    std::vector<std::vector<Neighbour>>& neighbours) const {
+    neighbours.resize(queries.size());
+    parallelFor<size_t>(0, queries.size(), [&](size_t begin, size_t end) {
+      for (size_t query = begin; query < end; ++query) {
+        radiusSearch(queries[query], radius, neighbours[query]);
+      }
+    }, 64);
+  }
+};
+
+#endif  //_KD_TREE_H_
@@ -2,58 +2,87 @@
 #ifndef _POINT_H_
 #define _POINT_H_
 
+#include <array>
 #include <cmath>
 #include <ostream>
 #include <algorithm>
+#include <vector>
 #include <boost/iterator/zip_iterator.hpp>
 #include <boost/iterator/iterator_adaptor.hpp>
 
+#include "mathUtils/fixedVectorOps.h"
 #include "mathUtils/vectorSpace.h"
-
-template <typename T, size_t N>
-class Vector;
+#include "geomUtils/vector.h"
 
 template <class T, size_t N>
-class Point {
- protected:
-  std::array<T, N> m_x;
+class Point : public VectorSpaceExpression<Point<T, N>> {
+ public:
+  typedef T value_type;
+  static constexpr size_t c_dimension = N;
+  // Float 3- and 4-vectors are padded to 4 aligned lanes for SSE
+  static constexpr size_t c_storageSize =
+      FixedVectorLayout<T, N>::c_storageSize;
+  typedef FixedVectorOps<T, N> Ops;
 
- private:
-  void swap(Point& other) { std::swap(m_x, other.m_x); }
+ protected:
+  alignas(FixedVectorLayout<T, N>::c_alignment)
+      std::array<T, c_storageSize> m_x;
 
  public:
-  Point() : m_x() {}
-  Point(Point&& other) : m_x(std::move(other.m_x)) {}
-  Point(const std::array<T, N>& x) : m_x(x) {}
-  Point(const Point& other) : m_x(other.m_x) {}
+  constexpr Point() : m_x() {}
+  constexpr Point(const std::array<T, N>& x) : m_x() {
+    for (size_t i = 0; i < N; ++i) {
+      m_x[i] = x[i];
+    }
+  }
+  constexpr Point(const Point& other) = default;
+  constexpr Point(Point&& other) = default;
+
+  // Evaluates a linear combination such as a * P + b * Q in one pass
+  template <typename E>
+  constexpr Point(const VectorSpaceExpression<E>& expression) : m_x() {
+    assignExpression(m_x, expression);
+  }
+
+  constexpr Point& operator=(const Point& other) = default;
+  constexpr Point& operator=(Point&& other) = default;
 
-  Point& operator=(Point other) {
-    swap(other);
+  template <typename E>
+  constexpr Point& operator=(const VectorSpaceExpression<E>& expression) {
+    assignExpression(m_x, expression);
     return *this;
   }
 
-  Point(const Point& p1, const Point& p2) {
-    *this = bilinearCombination<Point, Point, Point, N>(p1, p2, 0.5, 0.5);
+  template <typename E>
+  constexpr Point& operator+=(const VectorSpaceExpression<E>& expression) {
+    addExpression(m_x, expression);
+    return *this;
   }
 
-  Point(const std::vector<Point<T, N>>& points) {
-    T denominator = 1.0 / points.size();
-    std::array<T, N> denominators;
-    std::fill_n(denominators.begin(), denominators.size(), denominator);
-    *this =
-        multilinearCombination<Point, std::vector<Point>, std::array<T, N>, N>(
-            points, denominators);
+  constexpr Point(const Point& p1, const Point& p2) : m_x() {
+    assignExpression(m_x, T(0.5) * p1 + T(0.5) * p2);
   }
 
-  Point(const Point& point, T s, const Vector<T>& vector) {
-    swap(bilinearCombination(point, vector, 1, s));
+  // Centroid, summed in place in one pass. PointCloud::centroid is faster
+  // for many points
+  Point(const std::vector<Point<T, N>>& points) : m_x() {
+    for (const Point& point : points) {
+      addExpression(m_x, point);
+    }
+    if (!points.empty()) {
+      assignExpression(m_x, (T(1) / points.size()) * *this);
+    }
+  }
+
+  constexpr Point(const Point& point, T s, const Vector<T, N>& vector)
+      : m_x() {
+    Ops::addScaled(m_x.data(), point.data(), s, vector.data());
   }
 
   // Point + s ( other - point)
-  Point(const Point& point, float s, const Point& other) throw() {
-    Vector<T> vector(point, other);
-    Point temp(point, s, vector);
-    swap(temp);
+  constexpr Point(const Point& point, float s, const Point& other) throw()
+      : m_x() {
+    Ops::lerp(m_x.data(), point.data(), T(s), other.data());
   }
 
   // Point + sum(s[i] * v[i])
@@ -76,42 +105,36 @@ class Point {
   };
 
   // Advertise self as container
-  typedef dimension_iterator<typename std::array<T, N>::iterator> iterator;
-  typedef dimension_iterator<typename std::array<T, N>::const_iterator>
-      const_iterator;
-  typedef T value_type;
+  typedef dimension_iterator<typename std::array<T, c_storageSize>::iterator>
+      iterator;
+  typedef dimension_iterator<
+      typename std::array<T, c_storageSize>::const_iterator> const_iterator;
 
+  // The N coordinates, without any padding
   iterator begin() { return iterator(m_x.begin()); }
-  iterator end() { return iterator(m_x.end()); }
+  iterator end() { return iterator(m_x.begin() + N); }
+  const_iterator begin() const { return cbegin(); }
+  const_iterator end() const { return cend(); }
   const_iterator cbegin() const { return const_iterator(m_x.cbegin()); }
-  const_iterator cend() const { return const_iterator(m_x.cend()); }
-  const T& operator[](size_t xi) const { return m_x[xi]; }
-  T& operator[](size_t xi) { return m_x[xi]; }
-
-  Point& set(std::array<T,N>& x) {
-    m_x = x;
+  const_iterator cend() const { return const_iterator(m_x.cbegin() + N); }
+  constexpr const T& operator[](size_t xi) const { return m_x[xi]; }
+  constexpr T& operator[](size_t xi) { return m_x[xi]; }
+  constexpr const T* data() const { return m_x.data(); }
+
+  constexpr Point& set(const std::array<T, N>& x) {
+    for (size_t i = 0; i < N; ++i) {
+      m_x[i] = x[i];
+    }
     return *this;
   }
 
-  Point& set(const Point& other) {
+  constexpr Point& set(const Point& other) {
     m_x = other.m_x;
     return *this;
   }
 
-  T distance2(const Point& other) const {
-    auto iterBegin =
-        boost::make_zip_iterator(boost::make_tuple(cbegin(), other.cbegin()));
-    auto iterEnd =
-        boost::make_zip_iterator(boost::make_tuple(cend(), other.cend()));
-    T dist2 = std::accumulate(
-        iterBegin, iterEnd, static_cast<T>(0),
-        [](const boost::tuple<
-            typename std::iterator_traits<const_iterator>::value_type,
-            typename std::iterator_traits<const_iterator>::value_type>& tuple) {
-          return (boost::get<0>(tuple) - boost::get<1>(tuple)) *
-                 (boost::get<0>(tuple) - boost::get<1>(tuple));
-        });
-    return dist2;
+  constexpr T distance2(const Point& other) const {
+    return Ops::distance2(m_x.data(), other.m_x.data());
   }
 
   T distance(const Point& other) const throw() {
@@ -0,0 +1,261 @@
+// A structure-of-arrays container of n-dimensional points with batch kernels
+#ifndef _POINT_CLOUD_H_
+#define _POINT_CLOUD_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "geomUtils/point.h"
+#include "utils/functionHelpers.h"
+
+// Stores coordinate i of every point contiguously, so the batch kernels below
+// stream through plain arrays and compile to vector instructions across
+// points instead of working on one small Point at a time. Kernels split large
+// clouds into fixed blocks processed on worker threads; results do not depend
+// on the number of threads.
+template <class T, size_t N>
+class PointCloud {
+ private:
+  std::array<std::vector<T>, N> m_coordinates;
+
+  static const size_t c_blockSize = 1 << 14;
+
+  size_t numBlocks() const throw() {
+    return (size() + c_blockSize - 1) / c_blockSize;
+  }
+
+  // Call function(begin, end) on every block, in parallel
+  template <typename Function>
+  void forEachBlock(Function const& function) const {
+    size_t count = size();
+    parallelFor<size_t>(0, numBlocks(), [&](size_t first, size_t last) {
+      for (size_t block = first; block < last; ++block) {
+        function(block * c_blockSize,
+                 std::min(count, (block + 1) * c_blockSize));
+      }
+    }, 1);
+  }
+
+ public:
+  typedef Point<T, N> PointType;
+
+  PointCloud() {}
+
+  explicit PointCloud(const std::vector<PointType>& points) {
+    resize(points.size());
+    forEachBlock([&](size_t begin, size_t end) {
+      for (size_t axis = 0; axis < N; ++axis) {
+        T* __restrict coordinates = m_coordinates[axis].data();
+        for (size_t i = begin; i < end; ++i) {
+          coordinates[i] = points[i][axis];
+        }
+      }
+    });
+  }
+
+  size_t size() const throw() { return m_coordinates[0].size(); }
+  bool empty() const throw() { return size() == 0; }
+
+  void reserve(size_t capacity) {
+    for (std::vector<T>& coordinates : m_coordinates) {
+      coordinates.reserve(capacity);
+    }
+  }
+
+  void resize(size_t count) {
+    for (std::vector<T>& coordinates : m_coordinates) {
+      coordinates.resize(count);
+    }
+  }
+
+  void clear() {
+    for (std::vector<T>& coordinates : m_coordinates) {
+      coordinates.clear();
+    }
+  }
+
+  void push_back(const PointType& point) {
+    for (size_t axis = 0; axis < N; ++axis) {
+      m_coordinates[axis].push_back(point[axis]);
+    }
+  }
+
+  PointType point(size_t index) const {
+    PointType point;
+    for (size_t axis = 0; axis < N; ++axis) {
+      point[axis] = m_coordinates[axis][index];
+    }
+    return point;
+  }
+
+  void setPoint(size_t index, const PointType& point) {
+    for (size_t axis = 0; axis < N; ++axis) {
+      m_coordinates[axis][index] = point[axis];
+    }
+  }
+
+  // Coordinate axis of all points, size() values
+  const T* coordinates(size_t axis) const { return m_coordinates[axis].data(); }
+  T* coordinates(size_t axis) { return m_coordinates[axis].data(); }
+
+  std::vector<PointType> toPoints() const {
+    std::vector<PointType> points(size());
+    forEachBlock([&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        points[i] = point(i);
+      }
+    });
+    return points;
+  }
+
+  // Apply the affine transformation x' = A x + b given as a row-major
+  // (N + 1) x (N + 1) matrix [A b; 0 1] acting on column vectors, the layout
+  // of Matrix's elements. The last row is ignored.
+  void transform(const T (&matrix)[N + 1][N + 1]) {
+    forEachBlock([&](size_t begin, size_t end) {
+      T* pCoordinates[N];
+      for (size_t axis = 0; axis < N; ++axis) {
+        pCoordinates[axis] = m_coordinates[axis].data();
+      }
+      for (size_t i = begin; i < end; ++i) {
+        T input[N];
+        for (size_t axis = 0; axis < N; ++axis) {
+          input[axis] = pCoordinates[axis][i];
+        }
+        for (size_t row = 0; row < N; ++row) {
+          T sum = matrix[row][N];
+          for (size_t column = 0; column < N; ++column) {
+            sum += matrix[row][column] * input[column];
+          }
+          pCoordinates[row][i] = sum;
+        }
+      }
+    });
+  }
+
+  // Corners (low, high) of the axis aligned bounding box; inverted (low =
+  // max, high = lowest) for an empty cloud
+  std::pair<PointType, PointType> boundingBox() const {
+    std::vector<std::array<T, 2 * N>> partials(numBlocks());
+    forEachBlock([&](size_t begin, size_t end) {
+      std::array<T, 2 * N>& partial = partials[begin / c_blockSize];
+      for (size_t axis = 0; axis < N; ++axis) {
+        const T* __restrict coordinates = m_coordinates[axis].data();
+        T low = coordinates[begin];
+        T high = coordinates[begin];
+        for (size_t i = begin + 1; i < end; ++i) {
+          low = coordinates[i] < low ? coordinates[i] : low;
+          high = coordinates[i] > high ? coordinates[i] : high;
+        }
+        partial[axis] = low;
+        partial[N + axis] = high;
+      }
+    });
+
+    std::pair<PointType, PointType> box;
+    for (size_t axis = 0; axis < N; ++axis) {
+      box.first[axis] = std::numeric_limits<T>::max();
+      box.second[axis] = std::numeric_limits<T>::lowest();
+    }
+    for (const std::array<T, 2 * N>& partial : partials) {
+      for (size_t axis = 0; axis < N; ++axis) {
+        box.first[axis] = std::min(box.first[axis], partial[axis]);
+        box.second[axis] = std::max(box.second[axis], partial[N + axis]);
+      }
+    }
+    return box;
+  }
+
+  // Mean of all points, accumulated per block in double; the origin for an
+  // empty cloud
+  PointType centroid() const {
+    std::vector<std::array<double, N>> partials(numBlocks());
+    forEachBlock([&](size_t begin, size_t end) {
+      std::array<double, N>& partial = partials[begin / c_blockSize];
+      for (size_t axis = 0; axis < N; ++axis) {
+        const T* __restrict coordinates = m_coordinates[axis].data();
+        double sum = 0;
+        for (size_t i = begin; i < end; ++i) {
+          sum += coordinates[i];
+        }
+        partial[axis] = sum;
+      }
+    });
+
+    PointType centroid;
+    if (empty()) {
+      return centroid;
+    }
+    for (size_t axis = 0; axis < N; ++axis) {
+      double sum = 0;
+      for (const std::array<double, N>& partial : partials) {
+        sum += partial[axis];
+      }
+      centroid[axis] = T(sum / size());
+    }
+    return centroid;
+  }
+
+  // distances2[i] = squared distance from point i to query
+  void distance2(const PointType& query, std::vector<T>& distances2) const {
+    distances2.resize(size());
+    forEachBlock([&](size_t begin, size_t end) {
+      T* __restrict out = distances2.data();
+      std::fill(out + begin, out + end, T(0));
+      for (size_t axis = 0; axis < N; ++axis) {
+        const T* __restrict coordinates = m_coordinates[axis].data();
+        T queryCoordinate = query[axis];
+        for (size_t i = begin; i < end; ++i) {
+          T difference = coordinates[i] - queryCoordinate;
+          out[i] += difference * difference;
+        }
+      }
+    });
+  }
+
+  // Indices of the min(k, size()) points closest to query, nearest first.
+  // Ties go to the lower index
+  std::vector<size_t> kClosest(const PointType& query, size_t k) const {
+    std::vector<T> distances2;
+    distance2(query, distances2);
+    k = std::min(k, size());
+    auto closer = [&distances2](size_t a, size_t b) {
+      return distances2[a] < distances2[b] ||
+             (distances2[a] == distances2[b] && a < b);
+    };
+
+    // Each block keeps its k best, then the candidates are narrowed down
+    std::vector<std::vector<size_t>> candidates(numBlocks());
+    forEachBlock([&](size_t begin, size_t end) {
+      std::vector<size_t>& blockCandidates = candidates[begin / c_blockSize];
+      blockCandidates.resize(end - begin);
+      for (size_t i = begin; i < end; ++i) {
+        blockCandidates[i - begin] = i;
+      }
+      if (blockCandidates.size() > k) {
+        std::nth_element(blockCandidates.begin(), blockCandidates.begin() + k,
+                         blockCandidates.end(), closer);
+        blockCandidates.resize(k);
+      }
+    });
+
+    std::vector<size_t> closest;
+    for (const std::vector<size_t>& blockCandidates : candidates) {
+      closest.insert(closest.end(), blockCandidates.begin(),
+                     blockCandidates.end());
+    }
+    if (closest.size() > k) {
+      std::nth_element(closest.begin(), closest.begin() + k, closest.end(),
+                       closer);
+      closest.resize(k);
+    }
+    std::sort(closest.begin(), closest.end(), closer);
+    return closest;
+  }
+};
+
+#endif  //_POINT_CLOUD_H_
@@ -1,43 +1,393 @@
+// An open polyline of n-dimensional points with its measures, resampling,
+// simplification and nearest point queries
 #ifndef _POLYLINE_H_
 #define _POLYLINE_H_
 
-#include <boost/iterator_adaptors.hpp>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
 
-#include "point.h"
+#include "geomUtils/point.h"
+#include "geomUtils/pointCloud.h"
+#include "utils/dAryHeap.h"
+#include "utils/functionHelpers.h"
 
-template <typename T>
+// The vertices are stored as a PointCloud, one contiguous array per
+// coordinate, so that the loops over vertices and segments below compile to
+// vector instructions. The free functions at the end process many polylines
+// on worker threads.
+template <class T, size_t N>
 class Polyline {
  public:
-  Polyline();
+  typedef Point<T, N> PointType;
 
-  Polyline& operator=(const Polyline& other);
-  Polyline(const Polyline& other);
-  void swap(Polyline& other);
+  // The point at parameter t in [0, 1] along segment (segment, segment + 1)
+  // closest to a query, and its squared distance to it
+  struct Projection {
+    size_t segment;
+    T t;
+    T distance2;
+  };
 
-  virtual ~Polyline() {}
+ private:
+  PointCloud<T, N> m_vertices;
 
-  class iterator
-      : public boost::iterator_adaptor<iterator,
-                                       std::vector<Point<T>>::iterator> {
-   public:
-    iterator() : iterator::iterator_adaptor_() {}
+  // Segments are measured in blocks of this size on the stack, so that the
+  // kernels vectorize and the reductions over their results stay scalar
+  static constexpr size_t c_blockSize = 256;
 
-    explicit iterator(const iterator::iterator_adaptor_::base_type_& p)
-        : iterator::iterator_adaptor_(p) {}
-  };
+  std::array<const T*, N> coordinateArrays() const {
+    std::array<const T*, N> pCoordinates;
+    for (size_t axis = 0; axis < N; ++axis) {
+      pCoordinates[axis] = m_vertices.coordinates(axis);
+    }
+    return pCoordinates;
+  }
 
- private:
-  std::vector<Point<T>> m_points;
-};
+  // out[i] = squared length of segment (i, i + 1), numSegments() values
+  void squaredSegmentLengths(T* __restrict out) const {
+    size_t count = numSegments();
+    std::fill(out, out + count, T(0));
+    for (size_t axis = 0; axis < N; ++axis) {
+      const T* __restrict coordinates = m_vertices.coordinates(axis);
+      for (size_t i = 0; i < count; ++i) {
+        T difference = coordinates[i + 1] - coordinates[i];
+        out[i] += difference * difference;
+      }
+    }
+  }
+
+  // distances2[i - begin] = squared distance from vertex i to the segment
+  // (first, last), for i in [begin, end)
+  void distances2ToSegment(size_t first, size_t last, size_t begin,
+                           size_t end, T* __restrict distances2) const {
+    std::array<const T*, N> pCoordinates = coordinateArrays();
+    T start[N], direction[N];
+    T length2 = 0;
+    for (size_t axis = 0; axis < N; ++axis) {
+      start[axis] = pCoordinates[axis][first];
+      direction[axis] = pCoordinates[axis][last] - start[axis];
+      length2 += direction[axis] * direction[axis];
+    }
+    T inverseLength2 = length2 > 0 ? 1 / length2 : T(0);
+
+    for (size_t i = begin; i < end; ++i) {
+      T offset[N];
+      T along = 0;
+      for (size_t axis = 0; axis < N; ++axis) {
+        offset[axis] = pCoordinates[axis][i] - start[axis];
+        along += offset[axis] * direction[axis];
+      }
+      T t = std::min(std::max(along * inverseLength2, T(0)), T(1));
+      T distance2 = 0;
+      for (size_t axis = 0; axis < N; ++axis) {
+        T difference = offset[axis] - t * direction[axis];
+        distance2 += difference * difference;
+      }
+      distances2[i - begin] = distance2;
+    }
+  }
 
-// Convenience class for closed polylines
-// template <class T>
-// class ClosedPolyline : public Polyline<T> {};
+  // Area of the triangle of vertices a, b and c
+  T triangleArea(size_t a, size_t b, size_t c) const {
+    T uu = 0, vv = 0, uv = 0;
+    for (size_t axis = 0; axis < N; ++axis) {
+      const T* coordinates = m_vertices.coordinates(axis);
+      T u = coordinates[a] - coordinates[b];
+      T v = coordinates[c] - coordinates[b];
+      uu += u * u;
+      vv += v * v;
+      uv += u * v;
+    }
+    return T(0.5) * std::sqrt(std::max(uu * vv - uv * uv, T(0)));
+  }
+
+  // The polyline through the vertices i with fKeep[i] set
+  Polyline select(const std::vector<char>& fKeep) const {
+    size_t count = std::count(fKeep.begin(), fKeep.end(), char(1));
+    Polyline selected;
+    selected.m_vertices.resize(count);
+    for (size_t axis = 0; axis < N; ++axis) {
+      const T* coordinates = m_vertices.coordinates(axis);
+      T* out = selected.m_vertices.coordinates(axis);
+      for (size_t i = 0; i < size(); ++i) {
+        if (fKeep[i]) {
+          *out++ = coordinates[i];
+        }
+      }
+    }
+    return selected;
+  }
 
-/*class PolylineFactory {
  public:
-  std::auto_ptr<Polyline> get
-}*/
+  Polyline() {}
+
+  explicit Polyline(const std::vector<PointType>& points)
+      : m_vertices(points) {}
+
+  size_t size() const throw() { return m_vertices.size(); }
+  bool empty() const throw() { return m_vertices.empty(); }
+  size_t numSegments() const throw() { return empty() ? 0 : size() - 1; }
+
+  void reserve(size_t capacity) { m_vertices.reserve(capacity); }
+  void clear() { m_vertices.clear(); }
+  void push_back(const PointType& point) { m_vertices.push_back(point); }
+
+  PointType point(size_t index) const { return m_vertices.point(index); }
+  const PointCloud<T, N>& vertices() const throw() { return m_vertices; }
+
+  // Coordinate axis of all vertices, size() values
+  const T* coordinates(size_t axis) const {
+    return m_vertices.coordinates(axis);
+  }
+
+  // Sum of the segment lengths, accumulated in double
+  T length() const {
+    std::vector<T> lengths2(numSegments());
+    squaredSegmentLengths(lengths2.data());
+    double sum = 0;
+    for (T length2 : lengths2) {
+      sum += std::sqrt(length2);
+    }
+    return T(sum);
+  }
+
+  // arcLengths[i] = length along the polyline from vertex 0 to vertex i,
+  // accumulated in double; size() values
+  void arcLengths(std::vector<T>& arcLengths) const {
+    arcLengths.resize(size());
+    if (empty()) {
+      return;
+    }
+    arcLengths[0] = 0;
+    squaredSegmentLengths(arcLengths.data() + 1);
+    double sum = 0;
+    for (size_t i = 1; i < arcLengths.size(); ++i) {
+      sum += std::sqrt(arcLengths[i]);
+      arcLengths[i] = T(sum);
+    }
+  }
+
+  // Vertices every spacing along the polyline from its first vertex, followed
+  // by its last vertex unless the last sample falls on it
+  Polyline resample(T spacing) const {
+    assert(spacing > 0);
+    if (size() <= 1) {
+      return *this;
+    }
+    std::vector<T> arcs;
+    arcLengths(arcs);
+    double total = arcs.back();
+    size_t numSamples = static_cast<size_t>(total / spacing) + 1;
+    bool fAppendEnd = (numSamples - 1) * double(spacing) < total;
+
+    Polyline resampled;
+    resampled.m_vertices.resize(numSamples + (fAppendEnd ? 1 : 0));
+    std::array<const T*, N> pCoordinates = coordinateArrays();
+    size_t segment = 0;
+    for (size_t sample = 0; sample < numSamples; ++sample) {
+      double arc = sample * double(spacing);
+      while (segment + 1 < numSegments() && arcs[segment + 1] < arc) {
+        ++segment;
+      }
+      T segmentLength = arcs[segment + 1] - arcs[segment];
+      T t = segmentLength > 0 ? T((arc - arcs[segment]) / segmentLength)
+                              : T(0);
+      t = std::min(std::max(t, T(0)), T(1));
+      for (size_t axis = 0; axis < N; ++axis) {
+        const T* coordinates = pCoordinates[axis];
+        resampled.m_vertices.coordinates(axis)[sample] =
+            coordinates[segment] +
+            t * (coordinates[segment + 1] - coordinates[segment]);
+      }
+    }
+    if (fAppendEnd) {
+      resampled.m_vertices.setPoint(numSamples, point(size() - 1));
+    }
+    return resampled;
+  }
+
+  // Closest point of the polyline to query; the first one on ties. A single
+  // vertex is its own segment 0
+  Projection project(const PointType& query) const {
+    assert(!empty());
+    Projection best = {0, T(0), point(0).distance2(query)};
+    std::array<const T*, N> pCoordinates = coordinateArrays();
+    T ts[c_blockSize], distances2[c_blockSize];
+    for (size_t begin = 0; begin < numSegments(); begin += c_blockSize) {
+      size_t end = std::min(begin + c_blockSize, numSegments());
+      for (size_t i = begin; i < end; ++i) {
+        T direction[N], offset[N];
+        T along = 0, length2 = 0;
+        for (size_t axis = 0; axis < N; ++axis) {
+          direction[axis] = pCoordinates[axis][i + 1] - pCoordinates[axis][i];
+          offset[axis] = query[axis] - pCoordinates[axis][i];
+          along += offset[axis] * direction[axis];
+          length2 += direction[axis] * direction[axis];
+        }
+        T t = length2 > 0 ? along / length2 : T(0);
+        t = std::min(std::max(t, T(0)), T(1));
+        T distance2 = 0;
+        for (size_t axis = 0; axis < N; ++axis) {
+          T difference = offset[axis] - t * direction[axis];
+          distance2 += difference * difference;
+        }
+        ts[i - begin] = t;
+        distances2[i - begin] = distance2;
+      }
+      for (size_t i = begin; i < end; ++i) {
+        if (distances2[i - begin] < best.distance2) {
+          best.segment = i;
+          best.t = ts[i - begin];
+          best.distance2 = distances2[i - begin];
+        }
+      }
+    }
+    return best;
+  }
+
+  PointType pointAt(const Projection& projection) const {
+    PointType first = point(projection.segment);
+    if (projection.segment + 1 >= size()) {
+      return first;
+    }
+    return PointType(first, projection.t, point(projection.segment + 1));
+  }
+
+  PointType nearestPoint(const PointType& query) const {
+    return pointAt(project(query));
+  }
+
+  // Douglas-Peucker: keep the end vertices, then recursively the vertex
+  // farthest from the segment between two kept vertices while it is farther
+  // than tolerance. Uses an explicit stack, so long traces cannot overflow
+  Polyline simplifyDouglasPeucker(T tolerance) const {
+    if (size() <= 2) {
+      return *this;
+    }
+    std::vector<char> fKeep(size(), 0);
+    fKeep.front() = 1;
+    fKeep.back() = 1;
+    T tolerance2 = tolerance * tolerance;
+    T distances2[c_blockSize];
+    std::vector<std::pair<size_t, size_t>> ranges(
+        1, std::make_pair(size_t(0), size() - 1));
+    while (!ranges.empty()) {
+      std::pair<size_t, size_t> range = ranges.back();
+      ranges.pop_back();
+      size_t farthest = range.first;
+      T farthestDistance2 = tolerance2;
+      for (size_t begin = range.first + 1; begin < range.second;
+           begin += c_blockSize) {
+        size_t end = std::min(begin + c_blockSize, range.second);
+        distances2ToSegment(range.first, range.second, begin, end,
+                            distances2);
+        for (size_t i = begin; i < end; ++i) {
+          if (distances2[i - begin] > farthestDistance2) {
+            farthest = i;
+            farthestDistance2 = distances2[i - begin];
+          }
+        }
+      }
+      if (farthest != range.first) {
+        fKeep[farthest] = 1;
+        if (farthest - range.first > 1) {
+          ranges.push_back(std::make_pair(range.first, farthest));
+        }
+        if (range.second - farthest > 1) {
+          ranges.push_back(std::make_pair(farthest, range.second));
+        }
+      }
+    }
+    return select(fKeep);
+  }
+
+  // Visvalingam-Whyatt: repeatedly remove the interior vertex whose triangle
+  // with its neighbours has the smallest area, while that area is below
+  // minArea. A vertex's area is raised to that of the last removed vertex
+  // when its neighbours change, so removal order follows significance
+  Polyline simplifyVisvalingam(T minArea) const {
+    if (size() <= 2) {
+      return *this;
+    }
+    size_t last = size() - 1;
+    std::vector<size_t> previous(size()), next(size());
+    IndexedDAryHeap<T, int> heap(size());
+    for (size_t i = 1; i < last; ++i) {
+      previous[i] = i - 1;
+      next[i] = i + 1;
+      heap.pushOrDecrease(int(i), triangleArea(i - 1, i, i + 1));
+    }
+    next[0] = 1;
+    previous[last] = last - 1;
+
+    std::vector<char> fKeep(size(), 1);
+    while (!heap.empty() && heap.topKey() < minArea) {
+      T area = heap.topKey();
+      size_t vertex = heap.pop();
+      fKeep[vertex] = 0;
+      size_t before = previous[vertex];
+      size_t after = next[vertex];
+      next[before] = after;
+      previous[after] = before;
+      if (before != 0) {
+        heap.update(int(before),
+                    std::max(area, triangleArea(previous[before], before,
+                                                after)));
+      }
+      if (after != last) {
+        heap.update(int(after),
+                    std::max(area, triangleArea(before, after, next[after])));
+      }
+    }
+    return select(fKeep);
+  }
+};
+
+namespace PolylineDetail {
+// Polylines vary a lot in size, so threads take small batches of them
+const size_t c_minPolylinesPerThread = 8;
+
+// out[i] = function(polylines[i]), polylines in parallel
+template <class T, size_t N, typename Function>
+std::vector<Polyline<T, N>> map(const std::vector<Polyline<T, N>>& polylines,
+                                Function const& function) {
+  std::vector<Polyline<T, N>> out(polylines.size());
+  parallelFor<size_t>(0, polylines.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      out[i] = function(polylines[i]);
+    }
+  }, c_minPolylinesPerThread);
+  return out;
+}
+}  // namespace PolylineDetail
+
+template <class T, size_t N>
+std::vector<Polyline<T, N>> resample(
+    const std::vector<Polyline<T, N>>& polylines, T spacing) {
+  return PolylineDetail::map(polylines, [spacing](const Polyline<T, N>& p) {
+    return p.resample(spacing);
+  });
+}
+
+template <class T, size_t N>
+std::vector<Polyline<T, N>> simplifyDouglasPeucker(
+    const std::vector<Polyline<T, N>>& polylines, T tolerance) {
+  return PolylineDetail::map(polylines, [tolerance](const Polyline<T, N>& p) {
+    return p.simplifyDouglasPeucker(tolerance);
+  });
+}
 
+template <class T, size_t N>
+std::vector<Polyline<T, N>> simplifyVisvalingam(
+    const std::vector<Polyline<T, N>>& polylines, T minArea) {
+  return PolylineDetail::map(polylines, [minArea](const Polyline<T, N>& p) {
+    return p.simplifyVisvalingam(minArea);
+  });
+}
 
 #endif  //_POLYLINE_H_
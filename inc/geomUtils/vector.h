@@ -1,36 +1,75 @@
 #ifndef _VECTOR_H_
 #define _VECTOR_H_
 
+#include <array>
 #include <cmath>
+#include <boost/iterator/iterator_adaptor.hpp>
 
+#include "mathUtils/fixedVectorOps.h"
 #include "mathUtils/vectorSpace.h"
 
 template <class T, size_t N>
 class Point;
 
 template <class T, size_t N>
-class Vector {
- protected:
-  std::array<T, N> m_x;
+class Vector : public VectorSpaceExpression<Vector<T, N>> {
+ public:
+  typedef T value_type;
+  static constexpr size_t c_dimension = N;
+  // Float 3- and 4-vectors are padded to 4 aligned lanes for SSE
+  static constexpr size_t c_storageSize =
+      FixedVectorLayout<T, N>::c_storageSize;
+  typedef FixedVectorOps<T, N> Ops;
 
- private:
-  void swap(Point& other) { std::swap(m_x, other.m_x); }
+ protected:
+  alignas(FixedVectorLayout<T, N>::c_alignment)
+      std::array<T, c_storageSize> m_x;
 
  public:
-  Vector() : m_x() {}
-  Vector(Vector&& other) : m_x(std::move(other.m_x)) {}
-  Vector(const Vector& other) : m_x(other.m_x) {}
-  Vector(const std::array<T, N>& x) throw() : m_x(x) {}
-  Vector& operator=(Vector other) {
-    swap(other);
+  constexpr Vector() : m_x() {}
+  constexpr Vector(const Vector& other) = default;
+  constexpr Vector(Vector&& other) = default;
+  constexpr Vector(const std::array<T, N>& x) throw() : m_x() {
+    for (size_t i = 0; i < N; ++i) {
+      m_x[i] = x[i];
+    }
+  }
+  constexpr Vector& operator=(const Vector& other) = default;
+  constexpr Vector& operator=(Vector&& other) = default;
+
+  // Evaluates a linear combination such as a * U + b * V in one pass
+  template <typename E>
+  constexpr Vector(const VectorSpaceExpression<E>& expression) : m_x() {
+    assignExpression(m_x, expression);
+  }
+
+  template <typename E>
+  constexpr Vector& operator=(const VectorSpaceExpression<E>& expression) {
+    assignExpression(m_x, expression);
+    return *this;
+  }
+
+  template <typename E>
+  constexpr Vector& operator+=(const VectorSpaceExpression<E>& expression) {
+    addExpression(m_x, expression);
     return *this;
   }
 
-  Vector(const Point<T>& p1, const Point<T>& p2) {
-    *this = bilinearCombination<Vector, Point, Point, N>(p1, p2, 1, -1);
+  // p2 - p1
+  constexpr Vector(const Point<T, N>& p1, const Point<T, N>& p2) : m_x() {
+    assignExpression(m_x, p2 - p1);
+  }
+
+  constexpr Vector(T a, const Vector& vec) : m_x() {
+    assignExpression(m_x, a * vec);
   }
 
-  Vector(T a, const Vector& vec) { *this = scale<Vector, Vector, N>(vec, a); }
+  // Unit vector along the given axis
+  static constexpr Vector axis(size_t index) {
+    Vector unit;
+    unit.m_x[index] = T(1);
+    return unit;
+  }
 
   // Iterator interface for point dimensions
   template <typename BaseIterType>
@@ -45,96 +84,83 @@ class Vector {
   };
 
   // Advertise self as container
-  typedef dimension_iterator<typename std::array<T, N>::iterator> iterator;
-  typedef dimension_iterator<typename std::array<T, N>::const_iterator>
-      const_iterator;
-  typedef T value_type;
+  typedef dimension_iterator<typename std::array<T, c_storageSize>::iterator>
+      iterator;
+  typedef dimension_iterator<
+      typename std::array<T, c_storageSize>::const_iterator> const_iterator;
 
+  // The N coordinates, without any padding
   iterator begin() { return iterator(m_x.begin()); }
-  iterator end() { return iterator(m_x.end()); }
+  iterator end() { return iterator(m_x.begin() + N); }
+  const_iterator begin() const { return cbegin(); }
+  const_iterator end() const { return cend(); }
   const_iterator cbegin() const { return const_iterator(m_x.cbegin()); }
-  const_iterator cend() const { return const_iterator(m_x.cend()); }
-  const T& operator[](size_t xi) const { return m_x[xi]; }
-  T& operator[](size_t xi) { return m_x[xi]; }
-
-  Vector& set(std::array<T, N>& x) {
-    m_x = x;
+  const_iterator cend() const { return const_iterator(m_x.cbegin() + N); }
+  constexpr const T& operator[](size_t xi) const { return m_x[xi]; }
+  constexpr T& operator[](size_t xi) { return m_x[xi]; }
+  constexpr const T* data() const { return m_x.data(); }
+
+  constexpr Vector& set(const std::array<T, N>& x) {
+    for (size_t i = 0; i < N; ++i) {
+      m_x[i] = x[i];
+    }
     return *this;
   }
 
-  Vector& set(const Vector& other) throw() {
+  constexpr Vector& set(const Vector& other) throw() {
     m_x = other.m_x;
     return *this;
   }
 
-  Vector operator+(const Vector& other) const throw() {
-    return bilinearCombination<Vector, Vector, Vector, N>(*this, other, 1, 1);
+  constexpr T dot(const Vector& other) const throw() {
+    return Ops::dot(m_x.data(), other.m_x.data());
   }
 
-  T dot(const Vector& other) const throw() {
-    return innerProduct<Vector, Vector, N>(*this, other);
+  constexpr Vector cross(const Vector& other) const throw() {
+    Vector result;
+    Ops::cross(result.m_x.data(), m_x.data(), other.m_x.data());
+    return result;
   }
 
-  T get(int index) const throw() {}
+  constexpr T get(int index) const throw() { return m_x[index]; }
 
-  Vector& add(const Vector& other) throw() {
-    m_x += other.m_x;
-    m_y += other.m_y;
-    m_z += other.m_z;
+  constexpr Vector& add(const Vector& other) throw() {
+    Ops::addScaled(m_x.data(), m_x.data(), T(1), other.m_x.data());
     return *this;
   }
 
-  Vector& add(float scale, const Vector& other) throw() {
-    m_x += scale * other.m_x;
-    m_y += scale * other.m_y;
-    m_z += scale * other.m_z;
+  constexpr Vector& add(float scale, const Vector& other) throw() {
+    Ops::addScaled(m_x.data(), m_x.data(), T(scale), other.m_x.data());
     return *this;
   }
 
-  Vector& sub(const Vector& other) throw() {
-    m_x -= other.m_x;
-    m_y -= other.m_y;
-    m_z -= other.m_z;
+  constexpr Vector& sub(const Vector& other) throw() {
+    Ops::addScaled(m_x.data(), m_x.data(), T(-1), other.m_x.data());
     return *this;
   }
 
-  Vector& mul(T f) throw() {
-    m_x *= f;
-    m_y *= f;
-    m_z *= f;
+  constexpr Vector& mul(T f) throw() {
+    Ops::scale(m_x.data(), m_x.data(), f);
     return *this;
   }
 
-  Vector& div(T f) {
-    float recip = 1 / f;
+  constexpr Vector& div(T f) {
+    T recip = 1 / f;
     return mul(recip);
   }
 
-  Vector& rev() throw() {
-    m_x = -m_x;
-    m_y = -m_y;
-    m_z = -m_z;
-    return *this;
-  }
+  constexpr Vector& rev() throw() { return mul(T(-1)); }
 
-  T sqnorm() throw() { return (m_x * m_x + m_y * m_y + m_z * m_z); }
+  constexpr T sqnorm() const throw() { return dot(*this); }
 
-  T norm() throw() { return (sqrt(m_x * m_x + m_y * m_y + m_z * m_z)); }
+  T norm() const throw() { return sqrt(sqnorm()); }
 
   Vector& normalize() throw() {
-    float n = norm();
-    if (n > 0.000001) {
-      div(n);
-    }
+    Ops::normalize(m_x.data(), m_x.data(), T(0.000001));
     return *this;
   }
 };
 
-template <typename T>
-Vector<T> operator*(T scale, const Vector<T>& vector) {
-  return Vector<T>(scale * vector.x(), scale * vector.y(), scale * vector.z());
-}
-
 /*Vector(const Vector& vec, float a, const Vector& I,
          const Vector& J)  // Rotated vec by 'a' parallel to plane (I,J)
   {
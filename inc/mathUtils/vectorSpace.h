@@ -2,21 +2,25 @@
 #ifndef _VECTORSPACE_H_
 #define _VECTORSPACE_H_
 
-#include <typeinfo>
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <iterator>
+#include <type_traits>
+#include <typeinfo>
 #include <boost/iterator/zip_iterator.hpp>
 
 #include "utils/collectionHelpers.h"
 
 // Return a * V
 template <typename RetType, typename InputType>
-RetType scale(const InputType& input, typename InputType1::value_type scale) {
+RetType scale(const InputType& input, typename InputType::value_type scale) {
   static_assert(is_iterable<InputType>::value &
                     is_iterable<RetType>::value,
                 "The input type and return type must be iterable");
   RetType retValue;
   auto iter = retValue.begin();
-  for (x : input) {
+  for (const auto& x : input) {
     *iter = scale * x;
     ++iter;
   }
@@ -32,17 +36,17 @@ RetType bilinearCombination(const InputType1& val1, const InputType2& val2,
                     is_iterable<InputType2>::value &
                     is_iterable<RetType>::value,
                 "Both the input types and return type must be iterable");
+  typedef typename InputType1::const_iterator Iterator1;
+  typedef typename InputType2::const_iterator Iterator2;
   RetType retValue;
   auto iter = retValue.begin();
   std::for_each(
       boost::make_zip_iterator(boost::make_tuple(val1.cbegin(), val2.cbegin())),
       boost::make_zip_iterator(boost::make_tuple(val1.cend(), val2.cend())),
       [&iter, &fieldCoeff1, &fieldCoeff2](
-          const boost::tuple<typename std::iterator_traits<
-                                 typename InputType1::iterator>::value_type,
-                             typename std::iterator_traits<
-                                 typename InputType2::iterator>::value_type>&
-              tuple) {
+          const boost::tuple<
+              typename std::iterator_traits<Iterator1>::value_type,
+              typename std::iterator_traits<Iterator2>::value_type>& tuple) {
         *iter = fieldCoeff1* boost::get<0>(tuple) +
                 fieldCoeff2 * boost::get<1>(tuple);
         ++iter;
@@ -50,7 +54,7 @@ RetType bilinearCombination(const InputType1& val1, const InputType2& val2,
   return retValue;
 }
 
-// Result sum(f_i * V_i)
+// Result sum(f_i * V_i). RetType must value-initialize to zero
 template <typename RetType, typename InputType, typename FieldType>
 RetType multilinearCombination(const InputType& vals,
                                const FieldType& fieldCoeffs) {
@@ -60,80 +64,359 @@ RetType multilinearCombination(const InputType& vals,
   static_assert(std::is_same<typename FieldType::value_type,
                              typename InputType::value_type::value_type>::value,
                 "InputType and FieldType must contain the same types");
-  RetType retValue;
-  std::for_each(boost::make_zip_iterator(
-                    boost::make_tuple(vals.cbegin(), fieldCoeffs.cbegin())),
-                boost::make_zip_iterator(
-                    boost::make_tuple(vals.cend(), fieldCoeffs.cend())),
-                [&retValue](const boost::tuple<
-                    typename std::iterator_traits<
-                        typename InputType::iterator>::value_type,
-                    typename std::iterator_traits<
-                        typename FieldType::iterator>::value_type>& tuple) {
-                  retValue = bilinearCombination(retValue, boost::get<0>(tuple),
-                                                 1, boost::get<2>(tuple));
-                });
+  RetType retValue = RetType();
+  auto coeffIter = fieldCoeffs.cbegin();
+  for (auto valIter = vals.cbegin();
+       valIter != vals.cend() && coeffIter != fieldCoeffs.cend();
+       ++valIter, ++coeffIter) {
+    // Accumulate in place rather than through a bilinearCombination
+    // temporary per input
+    auto iter = retValue.begin();
+    for (const auto& x : *valIter) {
+      *iter += *coeffIter * x;
+      ++iter;
+    }
+  }
   return retValue;
 }
 
+//------------------------------Expression templates----------------------------
+// Linear combinations of fixed size vectors, e.g. a * P + b * Q - c * R, build
+// a tree of lightweight expression nodes instead of computing each step. The
+// tree is only evaluated when assigned to a vector, in a single loop unrolled
+// over the N coordinates, so no temporaries are materialized.
+//
+// A vector type takes part by deriving from VectorSpaceExpression<Itself> and
+// providing value_type, static c_dimension and c_storageSize, and a const
+// operator[]. Storage lanes past c_dimension must hold zero. When every vector
+// in an expression and the destination have the same padded storage, all
+// lanes are evaluated, so that float 3-vectors padded to 4 compile to whole
+// SSE register operations. Everything is constexpr, so combinations of
+// constant vectors can be computed at compile time.
+
+template <typename Derived>
+class VectorSpaceExpression {
+ public:
+  constexpr const Derived& derived() const {
+    return static_cast<const Derived&>(*this);
+  }
+};
+
+namespace VectorSpaceDetail {
+// Base of the intermediate nodes, which are held by value in their parents.
+// Vectors themselves are held by reference; they outlive the full expression
+struct ExpressionNode {};
+
+template <typename E>
+struct Operand {
+  typedef typename std::conditional<std::is_base_of<ExpressionNode, E>::value,
+                                    const E, const E&>::type type;
+};
+
+// Loops over the N coordinates, unrolled by template recursion
+template <size_t I, size_t N>
+struct Unrolled {
+  template <typename Dest, typename E>
+  static constexpr void assign(Dest& dest, const E& expression) {
+    dest[I] = expression[I];
+    Unrolled<I + 1, N>::assign(dest, expression);
+  }
+
+  template <typename Dest, typename E>
+  static constexpr void add(Dest& dest, const E& expression) {
+    dest[I] += expression[I];
+    Unrolled<I + 1, N>::add(dest, expression);
+  }
+
+  template <typename Dest, typename E, typename F>
+  static constexpr void addScaled(Dest& dest, const E& expression, F scale) {
+    dest[I] += scale * expression[I];
+    Unrolled<I + 1, N>::addScaled(dest, expression, scale);
+  }
+
+  template <typename E1, typename E2>
+  static constexpr typename E1::value_type dot(const E1& a, const E2& b) {
+    return a[I] * b[I] + Unrolled<I + 1, N>::dot(a, b);
+  }
+};
+
+template <size_t N>
+struct Unrolled<N, N> {
+  template <typename Dest, typename E>
+  static constexpr void assign(Dest&, const E&) {}
+
+  template <typename Dest, typename E>
+  static constexpr void add(Dest&, const E&) {}
+
+  template <typename Dest, typename E, typename F>
+  static constexpr void addScaled(Dest&, const E&, F) {}
+
+  template <typename E1, typename E2>
+  static constexpr typename E1::value_type dot(const E1&, const E2&) {
+    return typename E1::value_type(0);
+  }
+};
+
+template <typename E1, typename E2>
+struct CommonStorageSize {
+  static const size_t value = E1::c_storageSize == E2::c_storageSize
+                                  ? E1::c_storageSize
+                                  : E1::c_dimension;
+};
+
+// Lanes to evaluate when assigning E to Dest
+template <typename Dest, typename E>
+struct EvaluationWidth {
+  static const size_t value = E::c_dimension;
+};
+
+template <typename T, size_t S, typename E>
+struct EvaluationWidth<std::array<T, S>, E> {
+  static const size_t value = S == E::c_storageSize ? S : E::c_dimension;
+};
+}  // namespace VectorSpaceDetail
+
+template <typename E1, typename E2>
+class SumExpression
+    : public VectorSpaceExpression<SumExpression<E1, E2>>,
+      public VectorSpaceDetail::ExpressionNode {
+  static_assert(E1::c_dimension == E2::c_dimension,
+                "Only vectors of the same dimension can be added");
+  typename VectorSpaceDetail::Operand<E1>::type m_first;
+  typename VectorSpaceDetail::Operand<E2>::type m_second;
+
+ public:
+  typedef typename E1::value_type value_type;
+  static const size_t c_dimension = E1::c_dimension;
+  static const size_t c_storageSize =
+      VectorSpaceDetail::CommonStorageSize<E1, E2>::value;
+
+  constexpr SumExpression(const E1& first, const E2& second)
+      : m_first(first), m_second(second) {}
+  constexpr value_type operator[](size_t i) const {
+    return m_first[i] + m_second[i];
+  }
+};
+
+template <typename E1, typename E2>
+class DifferenceExpression
+    : public VectorSpaceExpression<DifferenceExpression<E1, E2>>,
+      public VectorSpaceDetail::ExpressionNode {
+  static_assert(E1::c_dimension == E2::c_dimension,
+                "Only vectors of the same dimension can be subtracted");
+  typename VectorSpaceDetail::Operand<E1>::type m_first;
+  typename VectorSpaceDetail::Operand<E2>::type m_second;
+
+ public:
+  typedef typename E1::value_type value_type;
+  static const size_t c_dimension = E1::c_dimension;
+  static const size_t c_storageSize =
+      VectorSpaceDetail::CommonStorageSize<E1, E2>::value;
+
+  constexpr DifferenceExpression(const E1& first, const E2& second)
+      : m_first(first), m_second(second) {}
+  constexpr value_type operator[](size_t i) const {
+    return m_first[i] - m_second[i];
+  }
+};
+
+template <typename E>
+class ScaledExpression : public VectorSpaceExpression<ScaledExpression<E>>,
+                         public VectorSpaceDetail::ExpressionNode {
+ public:
+  typedef typename E::value_type value_type;
+  static const size_t c_dimension = E::c_dimension;
+  static const size_t c_storageSize = E::c_storageSize;
+
+ private:
+  typename VectorSpaceDetail::Operand<E>::type m_expression;
+  value_type m_scale;
+
+ public:
+  constexpr ScaledExpression(const E& expression, value_type scale)
+      : m_expression(expression), m_scale(scale) {}
+  constexpr value_type operator[](size_t i) const {
+    return m_scale * m_expression[i];
+  }
+};
+
+template <typename E1, typename E2>
+constexpr SumExpression<E1, E2> operator+(
+    const VectorSpaceExpression<E1>& first,
+    const VectorSpaceExpression<E2>& second) {
+  return SumExpression<E1, E2>(first.derived(), second.derived());
+}
+
+template <typename E1, typename E2>
+constexpr DifferenceExpression<E1, E2> operator-(
+    const VectorSpaceExpression<E1>& first,
+    const VectorSpaceExpression<E2>& second) {
+  return DifferenceExpression<E1, E2>(first.derived(), second.derived());
+}
+
+template <typename E>
+constexpr ScaledExpression<E> operator*(
+    typename E::value_type scale, const VectorSpaceExpression<E>& expression) {
+  return ScaledExpression<E>(expression.derived(), scale);
+}
+
+template <typename E>
+constexpr ScaledExpression<E> operator*(
+    const VectorSpaceExpression<E>& expression, typename E::value_type scale) {
+  return ScaledExpression<E>(expression.derived(), scale);
+}
+
+template <typename E>
+constexpr ScaledExpression<E> operator-(
+    const VectorSpaceExpression<E>& expression) {
+  return ScaledExpression<E>(expression.derived(),
+                             typename E::value_type(-1));
+}
+
+// dest[i] = expression[i] for all i, in one unrolled pass
+template <typename Dest, typename E>
+constexpr void assignExpression(Dest& dest,
+                                const VectorSpaceExpression<E>& expression) {
+  const size_t width = VectorSpaceDetail::EvaluationWidth<Dest, E>::value;
+  VectorSpaceDetail::Unrolled<0, width>::assign(dest, expression.derived());
+}
+
+// dest[i] += expression[i] for all i, in one unrolled pass
+template <typename Dest, typename E>
+constexpr void addExpression(Dest& dest,
+                             const VectorSpaceExpression<E>& expression) {
+  const size_t width = VectorSpaceDetail::EvaluationWidth<Dest, E>::value;
+  VectorSpaceDetail::Unrolled<0, width>::add(dest, expression.derived());
+}
+
+// sum(a[i] * b[i])
+template <typename E1, typename E2>
+constexpr typename E1::value_type innerProduct(
+    const VectorSpaceExpression<E1>& a, const VectorSpaceExpression<E2>& b) {
+  static_assert(E1::c_dimension == E2::c_dimension,
+                "Only vectors of the same dimension have an inner product");
+  return VectorSpaceDetail::Unrolled<0, E1::c_dimension>::dot(a.derived(),
+                                                              b.derived());
+}
+
 //------------Specialize for fixed size containers for speed------------------
+namespace VectorSpaceDetail {
+template <typename Type>
+struct IsExpression {
+  static const bool value =
+      std::is_base_of<VectorSpaceExpression<Type>, Type>::value;
+};
+
+// Vector space types go through expressions, to use their padded storage
+template <typename RetType, typename InputType, size_t N>
+constexpr void scale(RetType& retValue, const InputType& input,
+                     typename InputType::value_type scale, std::true_type) {
+  retValue = scale * input;
+}
+
+template <typename RetType, typename InputType, size_t N>
+constexpr void scale(RetType& retValue, const InputType& input,
+                     typename InputType::value_type scale, std::false_type) {
+  for (size_t i = 0; i < N; ++i) {
+    retValue[i] = scale * input[i];
+  }
+}
+
+template <size_t N, typename RetType, typename InputType>
+constexpr void addScaled(RetType& retValue, const InputType& input,
+                         typename InputType::value_type scale, std::true_type) {
+  retValue += scale * input;
+}
+
+template <size_t N, typename RetType, typename InputType>
+constexpr void addScaled(RetType& retValue, const InputType& input,
+                         typename InputType::value_type scale,
+                         std::false_type) {
+  Unrolled<0, N>::addScaled(retValue, input, scale);
+}
+
+template <typename RetType, typename InputType1, typename InputType2,
+          size_t N>
+constexpr void bilinearCombination(RetType& retValue, const InputType1& val1,
+                                   const InputType2& val2,
+                                   typename InputType1::value_type fieldCoeff1,
+                                   typename InputType1::value_type fieldCoeff2,
+                                   std::true_type) {
+  retValue = fieldCoeff1 * val1 + fieldCoeff2 * val2;
+}
+
+template <typename RetType, typename InputType1, typename InputType2,
+          size_t N>
+constexpr void bilinearCombination(RetType& retValue, const InputType1& val1,
+                                   const InputType2& val2,
+                                   typename InputType1::value_type fieldCoeff1,
+                                   typename InputType1::value_type fieldCoeff2,
+                                   std::false_type) {
+  for (size_t i = 0; i < N; ++i) {
+    retValue[i] = fieldCoeff1 * val1[i] + fieldCoeff2 * val2[i];
+  }
+}
+}  // namespace VectorSpaceDetail
+
 // Scale
 template <typename RetType, typename InputType, size_t N>
-RetType scale(const InputType& input, typename InputType::value_type scale) {
+constexpr RetType scale(const InputType& input,
+                        typename InputType::value_type scale) {
   static_assert(is_iterable<InputType>::value &
                     is_iterable<RetType>::value,
                 "The input type and return type must be iterable");
-  RetType retValue;
-  for (int i = 0; i < N; ++i) {
-    retValue[i] = scale * input[i];
-  }
+  RetType retValue = RetType();
+  VectorSpaceDetail::scale<RetType, InputType, N>(
+      retValue, input, scale,
+      std::integral_constant<
+          bool, VectorSpaceDetail::IsExpression<RetType>::value &&
+                    VectorSpaceDetail::IsExpression<InputType>::value>());
   return retValue;
 }
 
 // Return f_1 * V + f_2 * U.
 template <typename RetType, typename InputType1, typename InputType2, size_t N>
-RetType bilinearCombination(const InputType1& val1, const InputType2& val2,
-                            typename InputType1::value_type fieldCoeff1,
-                            typename InputType1::value_type fieldCoeff2) {
+constexpr RetType bilinearCombination(
+    const InputType1& val1, const InputType2& val2,
+    typename InputType1::value_type fieldCoeff1,
+    typename InputType1::value_type fieldCoeff2) {
   static_assert(is_iterable<InputType1>::value &
                     is_iterable<InputType2>::value &
                     is_iterable<RetType>::value,
                 "Both the input types and return type must be iterable");
-  RetType retValue;
-  for (size_t i = 0; i < N; ++i) {
-    retValue[i] = fieldCoeff1 * val1[i] + fieldCoeff2 * val2[i];
-  }
+  RetType retValue = RetType();
+  VectorSpaceDetail::bilinearCombination<RetType, InputType1, InputType2, N>(
+      retValue, val1, val2, fieldCoeff1, fieldCoeff2,
+      std::integral_constant<
+          bool, VectorSpaceDetail::IsExpression<RetType>::value &&
+                    VectorSpaceDetail::IsExpression<InputType1>::value &&
+                    VectorSpaceDetail::IsExpression<InputType2>::value>());
   return retValue;
 }
 
-// Result sum(f_i * V_i)
+// Result sum(f_i * V_i), accumulated in place with an unrolled inner loop
 template <typename RetType, typename InputType, typename FieldType, size_t N>
-RetType multilinearCombination(const InputType& vals,
-                               const FieldType& fieldCoeffs) {
+constexpr RetType multilinearCombination(const InputType& vals,
+                                         const FieldType& fieldCoeffs) {
   static_assert(is_iterable<InputType>::value & is_iterable<RetType>::value &
                     is_iterable<FieldType>::value,
                 "InputType, ReturnType and FieldType must be iterable");
   static_assert(
-      boost::is_same<typename FieldType::value_type,
-                     typename InputType::value_type::value_type>::value,
+      std::is_same<typename FieldType::value_type,
+                   typename InputType::value_type::value_type>::value,
       "InputType and FieldType must contain the same types");
-  RetType retValue;
-  std::for_each(
-      boost::make_zip_iterator(
-          boost::make_tuple(vals.cbegin(), fieldCoeffs.cbegin())),
-      boost::make_zip_iterator(
-          boost::make_tuple(vals.cend(), fieldCoeffs.cend())),
-      [&retValue](const boost::tuple<
-          typename std::iterator_traits<
-              typename InputType::const_iterator>::value_type,
-          typename std::iterator_traits<
-              typename FieldType::const_iterator>::value_type>& tuple) {
-        retValue = bilinearCombination<
-            RetType, RetType,
-            typename std::iterator_traits<
-                typename InputType::const_iterator>::value_type,
-            N>(retValue, boost::get<0>(tuple), 1, boost::get<1>(tuple));
-      });
+  RetType retValue = RetType();
+  auto coeffIter = fieldCoeffs.cbegin();
+  for (auto valIter = vals.cbegin();
+       valIter != vals.cend() && coeffIter != fieldCoeffs.cend();
+       ++valIter, ++coeffIter) {
+    VectorSpaceDetail::addScaled<N>(
+        retValue, *valIter, *coeffIter,
+        std::integral_constant<
+            bool, VectorSpaceDetail::IsExpression<RetType>::value &&
+                      VectorSpaceDetail::IsExpression<
+                          typename InputType::value_type>::value>());
+  }
   return retValue;
 }
 
@@ -76,4 +76,19 @@ std::map<T, int> computeHistogram(const std::vector<T>& values) {
   return retVal;
 }
 
+// Populate a histogram of counts of each value in a vector of small
+// non-negative integers. histogram[value] is the count of value
+template <class T>
+std::vector<int> computeDenseHistogram(const std::vector<T>& values) {
+  std::vector<int> retVal;
+  std::for_each(values.begin(), values.end(), [&retVal](T value) {
+    assert(value >= 0);
+    if (size_t(value) >= retVal.size()) {
+      retVal.resize(size_t(value) + 1, 0);
+    }
+    retVal[value]++;
+  });
+  return retVal;
+}
+
 #endif  //_COLLECTION_HELPERS_H_
@@ -0,0 +1,129 @@
+#ifndef _D_ARY_HEAP_H_
+#define _D_ARY_HEAP_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cassert>
+
+// Indexed min-heap over integer ids in [0, maxId) with decrease-key. Children
+// of a node are stored contiguously so that a sift-down touches a single cache
+// line for the default arity of 4. clear() only resets the ids that were
+// touched, so a heap can be reused across many small queries cheaply.
+template <class KeyType, class IdType = int, unsigned int D = 4>
+class IndexedDAryHeap {
+ private:
+  typedef std::pair<KeyType, IdType> Entry;
+
+  std::vector<Entry> m_heap;
+  std::vector<int> m_position;  // -1 => not in heap
+  std::vector<IdType> m_touched;
+
+  void place(size_t slot, const Entry& entry) {
+    m_heap[slot] = entry;
+    m_position[entry.second] = static_cast<int>(slot);
+  }
+
+  void siftUp(size_t slot) {
+    Entry entry = m_heap[slot];
+    while (slot > 0) {
+      size_t parent = (slot - 1) / D;
+      if (!(entry.first < m_heap[parent].first)) {
+        break;
+      }
+      place(slot, m_heap[parent]);
+      slot = parent;
+    }
+    place(slot, entry);
+  }
+
+  void siftDown(size_t slot) {
+    Entry entry = m_heap[slot];
+    size_t size = m_heap.size();
+    while (true) {
+      size_t firstChild = D * slot + 1;
+      if (firstChild >= size) {
+        break;
+      }
+      size_t lastChild = std::min<size_t>(firstChild + D, size);
+      size_t minChild = firstChild;
+      for (size_t child = firstChild + 1; child < lastChild; ++child) {
+        if (m_heap[child].first < m_heap[minChild].first) {
+          minChild = child;
+        }
+      }
+      if (!(m_heap[minChild].first < entry.first)) {
+        break;
+      }
+      place(slot, m_heap[minChild]);
+      slot = minChild;
+    }
+    place(slot, entry);
+  }
+
+ public:
+  explicit IndexedDAryHeap(size_t maxId = 0) : m_position(maxId, -1) {}
+
+  void resize(size_t maxId) { m_position.assign(maxId, -1); }
+
+  bool empty() const throw() { return m_heap.empty(); }
+  size_t size() const throw() { return m_heap.size(); }
+  bool contains(IdType id) const throw() { return m_position[id] >= 0; }
+
+  const KeyType& topKey() const { return m_heap.front().first; }
+  IdType topId() const { return m_heap.front().second; }
+
+  // Insert id with key, or lower its key if it is already present. Returns
+  // false if the id was present with a key that is not larger.
+  bool pushOrDecrease(IdType id, const KeyType& key) {
+    int slot = m_position[id];
+    if (slot < 0) {
+      m_heap.push_back(Entry(key, id));
+      m_touched.push_back(id);
+      siftUp(m_heap.size() - 1);
+      return true;
+    }
+    if (!(key < m_heap[slot].first)) {
+      return false;
+    }
+    m_heap[slot].first = key;
+    siftUp(slot);
+    return true;
+  }
+
+  // Change the key of an id in the heap to any value
+  void update(IdType id, const KeyType& key) {
+    int slot = m_position[id];
+    assert(slot >= 0);
+    bool fDecrease = key < m_heap[slot].first;
+    m_heap[slot].first = key;
+    if (fDecrease) {
+      siftUp(slot);
+    } else {
+      siftDown(slot);
+    }
+  }
+
+  IdType pop() {
+    assert(!m_heap.empty());
+    IdType id = m_heap.front().second;
+    m_position[id] = -1;
+    Entry last = m_heap.back();
+    m_heap.pop_back();
+    if (!m_heap.empty()) {
+      m_heap.front() = last;
+      siftDown(0);
+    }
+    return id;
+  }
+
+  void clear() {
+    for (IdType id : m_touched) {
+      m_position[id] = -1;
+    }
+    m_touched.clear();
+    m_heap.clear();
+  }
+};
+
+#endif  //_D_ARY_HEAP_H_
@@ -3,6 +3,8 @@
 
 #include <thread>
 #include <chrono>
+#include <vector>
+#include <algorithm>
 
 template <typename Function>
 void callAfter(long millis, Function const& function) {
@@ -12,4 +14,78 @@ void callAfter(long millis, Function const& function) {
   }).detach();
 }
 
+// Number of worker threads to use for data parallel loops
+inline unsigned int numWorkerThreads() {
+  unsigned int numThreads = std::thread::hardware_concurrency();
+  return numThreads == 0 ? 1 : numThreads;
+}
+
+// Split [begin, end) into contiguous chunks and call function(chunkBegin,
+// chunkEnd) for each chunk on its own thread. Ranges smaller than
+// minChunkSize run inline on the calling thread.
+template <typename IndexType, typename Function>
+void parallelFor(IndexType begin, IndexType end, Function const& function,
+                 IndexType minChunkSize = IndexType(4096)) {
+  if (end <= begin) {
+    return;
+  }
+  IndexType range = end - begin;
+  IndexType numChunks = std::min<IndexType>(
+      IndexType(numWorkerThreads()),
+      (range + minChunkSize - 1) / std::max<IndexType>(minChunkSize, 1));
+  if (numChunks <= 1) {
+    function(begin, end);
+    return;
+  }
+
+  IndexType chunkSize = (range + numChunks - 1) / numChunks;
+  std::vector<std::thread> workers;
+  workers.reserve(numChunks - 1);
+  for (IndexType chunkBegin = begin + chunkSize; chunkBegin < end;
+       chunkBegin += chunkSize) {
+    IndexType chunkEnd = std::min<IndexType>(chunkBegin + chunkSize, end);
+    workers.emplace_back([&function, chunkBegin, chunkEnd]() {
+      function(chunkBegin, chunkEnd);
+    });
+  }
+  function(begin, std::min<IndexType>(begin + chunkSize, end));
+  std::for_each(workers.begin(), workers.end(),
+                [](std::thread& worker) { worker.join(); });
+}
+
+// Sort [begin, end) by sorting one chunk per worker thread and then merging
+// neighbouring chunks pairwise, each level of merges in parallel
+template <typename RandomIterator, typename Compare>
+void parallelSort(RandomIterator begin, RandomIterator end,
+                  Compare const& compare, size_t minChunkSize = 1 << 16) {
+  size_t size = end - begin;
+  size_t numChunks = std::min<size_t>(
+      numWorkerThreads(), (size + minChunkSize - 1) / minChunkSize);
+  if (numChunks <= 1) {
+    std::sort(begin, end, compare);
+    return;
+  }
+
+  size_t chunkSize = (size + numChunks - 1) / numChunks;
+  parallelFor<size_t>(0, numChunks, [&](size_t first, size_t last) {
+    for (size_t chunk = first; chunk < last; ++chunk) {
+      std::sort(begin + std::min(chunk * chunkSize, size),
+                begin + std::min((chunk + 1) * chunkSize, size), compare);
+    }
+  }, 1);
+
+  for (size_t width = chunkSize; width < size; width *= 2) {
+    size_t numMerges = (size + 2 * width - 1) / (2 * width);
+    parallelFor<size_t>(0, numMerges, [&](size_t first, size_t last) {
+      for (size_t merge = first; merge < last; ++merge) {
+        size_t mergeBegin = merge * 2 * width;
+        size_t middle = std::min(mergeBegin + width, size);
+        size_t mergeEnd = std::min(mergeBegin + 2 * width, size);
+        std::inplace_merge(begin + mergeBegin, begin + middle, begin + mergeEnd,
+                           compare);
+      }
+    }, 1);
+  }
+}
+
 #endif  //_FUNCTION_HELPERS_H_
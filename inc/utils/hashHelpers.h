@@ -0,0 +1,48 @@
+#ifndef _HASH_HELPERS_H_
+#define _HASH_HELPERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 64 bit MurmurHash2 (MurmurHash64A) of a block of bytes. Fast, but not
+// cryptographic, so only suited to keying caches of our own data
+inline uint64_t hashBytes(const void* pData, size_t numBytes,
+                          uint64_t seed = 0) {
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+
+  uint64_t hash = seed ^ (numBytes * m);
+  size_t numWords = numBytes / 8;
+  for (size_t i = 0; i < numWords; ++i) {
+    uint64_t word;
+    std::memcpy(&word, pBytes + 8 * i, 8);  // Input need not be aligned
+    word *= m;
+    word ^= word >> r;
+    word *= m;
+    hash ^= word;
+    hash *= m;
+  }
+
+  const unsigned char* pTail = pBytes + 8 * numWords;
+  size_t tailSize = numBytes & 7;
+  if (tailSize > 0) {
+    for (size_t i = 0; i < tailSize; ++i) {
+      hash ^= uint64_t(pTail[i]) << (8 * i);
+    }
+    hash *= m;
+  }
+
+  hash ^= hash >> r;
+  hash *= m;
+  hash ^= hash >> r;
+  return hash;
+}
+
+// Mix value into an existing hash. Order dependent
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+  return hashBytes(&value, sizeof(value), seed);
+}
+
+#endif  //_HASH_HELPERS_H_
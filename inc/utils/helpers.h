@@ -6,6 +6,7 @@
 
 #include "strHelpers.h"
 #include "numhelpers.h"
+#include "hashHelpers.h"
 #include "collectionHelpers.h"
 #include "functionHelpers.h"
 
@@ -1,14 +1,19 @@
 #ifndef _NUM_HELPERS_H_
 #define _NUM_HELPERS_H_
 
-// Quantizes a value that is guaranteed to lie between minValue and maxValue to
-// use the desired number of bits. This is a uniform quantization
-template <class T, class U>
-T quantizeValue(U value, U minValue, U maxValue, int numBits);
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
 
-// Quantize assuming -maxValue to maxValue. Again uniform quantization
-template <class T, class U>
-T quantizeValue(U value, U maxValue, int numBits);
+#include "functionHelpers.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NUM_HELPERS_SSE2
+#include <emmintrin.h>
+#endif
 
 // Delta encoding of two values
 template <class T>
@@ -27,6 +32,232 @@ T clamp(T value, T minValue, T maxValue) {
   return value;
 }
 
+// Quantizes a value that is guaranteed to lie between minValue and maxValue to
+// use the desired number of bits. This is a uniform quantization. Defined
+// inline so that loops over many values can be vectorized
+template <class T, class U>
+inline T quantizeValue(U value, U minValue, U maxValue, int numBits) {
+  U normalized = (value - minValue) / (maxValue - minValue);
+  T scaleNumber = T(1) << numBits;
+  T quantized = T(scaleNumber * normalized);
+  return clamp<T>(quantized, T(0), scaleNumber);
+}
+
+// Quantize assuming -maxValue to maxValue. Again uniform quantization
+template <class T, class U>
+inline T quantizeValue(U value, U maxValue, int numBits) {
+  return quantizeValue<T, U>(value, -maxValue, maxValue, numBits);
+}
+
+// Batch quantization. Unlike quantizeValue, codes span 0 to 2^numBits - 1 and
+// round to the nearest level, so that dequantizing a value of [minValue,
+// maxValue] is off by at most half a step. Values outside the range clamp to
+// its ends, NaNs to minValue. Large spans are split across worker threads.
+const int c_quantizationBitDepths[] = {8, 10, 12, 16};
+const size_t c_minQuantizedValuesPerThread = 1 << 16;
+
+template <class U>
+inline U quantizationStep(U minValue, U maxValue, int numBits) {
+  return (maxValue - minValue) / U((1 << numBits) - 1);
+}
+
+// Smallest of c_quantizationBitDepths that dequantizes every value of
+// [minValue, maxValue] to within maxError; 0 if none does
+template <class U>
+int quantizationBits(U minValue, U maxValue, U maxError) {
+  for (int numBits : c_quantizationBitDepths) {
+    if (quantizationStep(minValue, maxValue, numBits) / 2 <= maxError) {
+      return numBits;
+    }
+  }
+  return 0;
+}
+
+namespace NumHelpersDetail {
+// Plain loops for any types, which also finish the spans of the SSE kernels
+template <class U, class T>
+void quantize(const U* __restrict values, size_t count, U minValue, U scale,
+              U maxCode, T* __restrict codes) {
+  for (size_t i = 0; i < count; ++i) {
+    U scaled = (values[i] - minValue) * scale;
+    scaled = scaled > 0 ? scaled : U(0);
+    scaled = scaled < maxCode ? scaled : maxCode;
+    codes[i] = T(int32_t(scaled + U(0.5)));
+  }
+}
+
+template <class T, class U>
+void dequantize(const T* __restrict codes, size_t count, U minValue, U step,
+                U* __restrict values) {
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = minValue + U(codes[i]) * step;
+  }
+}
+
+#ifdef NUM_HELPERS_SSE2
+// Codes of four floats as 32 bit integers. _mm_max_ps returns its second
+// operand when either is NaN, so NaNs go to 0 as in the plain loop
+inline __m128i quantize4(const float* values, __m128 minValue, __m128 scale,
+                         __m128 maxCode) {
+  __m128 scaled = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values), minValue), scale);
+  scaled = _mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()), maxCode);
+  return _mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f)));
+}
+
+inline void quantize(const float* __restrict values, size_t count,
+                     float minValue, float scale, float maxCode,
+                     uint16_t* __restrict codes) {
+  __m128 minValues = _mm_set1_ps(minValue);
+  __m128 scales = _mm_set1_ps(scale);
+  __m128 maxCodes = _mm_set1_ps(maxCode);
+  // SSE2 only packs with signed saturation, so the codes are packed offset
+  // by -2^15 and shifted back by flipping the top bit
+  __m128i offset = _mm_set1_epi32(1 << 15);
+  __m128i topBit = _mm_set1_epi16(int16_t(0x8000));
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i low = quantize4(values + i, minValues, scales, maxCodes);
+    __m128i high = quantize4(values + i + 4, minValues, scales, maxCodes);
+    __m128i packed = _mm_packs_epi32(_mm_sub_epi32(low, offset),
+                                     _mm_sub_epi32(high, offset));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i),
+                     _mm_xor_si128(packed, topBit));
+  }
+  quantize<float, uint16_t>(values + i, count - i, minValue, scale, maxCode,
+                            codes + i);
+}
+
+inline void quantize(const float* __restrict values, size_t count,
+                     float minValue, float scale, float maxCode,
+                     uint8_t* __restrict codes) {
+  __m128 minValues = _mm_set1_ps(minValue);
+  __m128 scales = _mm_set1_ps(scale);
+  __m128 maxCodes = _mm_set1_ps(maxCode);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i codes0 = quantize4(values + i, minValues, scales, maxCodes);
+    __m128i codes1 = quantize4(values + i + 4, minValues, scales, maxCodes);
+    __m128i codes2 = quantize4(values + i + 8, minValues, scales, maxCodes);
+    __m128i codes3 = quantize4(values + i + 12, minValues, scales, maxCodes);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i),
+                     _mm_packus_epi16(_mm_packs_epi32(codes0, codes1),
+                                      _mm_packs_epi32(codes2, codes3)));
+  }
+  quantize<float, uint8_t>(values + i, count - i, minValue, scale, maxCode,
+                           codes + i);
+}
+
+// minValue + step * codes for four codes given as 32 bit integers
+inline void dequantize4(__m128i codes, __m128 minValue, __m128 step,
+                        float* values) {
+  _mm_storeu_ps(values,
+                _mm_add_ps(minValue, _mm_mul_ps(_mm_cvtepi32_ps(codes), step)));
+}
+
+inline void dequantize(const uint16_t* __restrict codes, size_t count,
+                       float minValue, float step, float* __restrict values) {
+  __m128 minValues = _mm_set1_ps(minValue);
+  __m128 steps = _mm_set1_ps(step);
+  __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+    dequantize4(_mm_unpacklo_epi16(packed, zero), minValues, steps, values + i);
+    dequantize4(_mm_unpackhi_epi16(packed, zero), minValues, steps,
+                values + i + 4);
+  }
+  dequantize<uint16_t, float>(codes + i, count - i, minValue, step,
+                              values + i);
+}
+
+inline void dequantize(const uint8_t* __restrict codes, size_t count,
+                       float minValue, float step, float* __restrict values) {
+  __m128 minValues = _mm_set1_ps(minValue);
+  __m128 steps = _mm_set1_ps(step);
+  __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i packed =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i));
+    __m128i low = _mm_unpacklo_epi8(packed, zero);
+    __m128i high = _mm_unpackhi_epi8(packed, zero);
+    dequantize4(_mm_unpacklo_epi16(low, zero), minValues, steps, values + i);
+    dequantize4(_mm_unpackhi_epi16(low, zero), minValues, steps,
+                values + i + 4);
+    dequantize4(_mm_unpacklo_epi16(high, zero), minValues, steps,
+                values + i + 8);
+    dequantize4(_mm_unpackhi_epi16(high, zero), minValues, steps,
+                values + i + 12);
+  }
+  dequantize<uint8_t, float>(codes + i, count - i, minValue, step, values + i);
+}
+#endif  // NUM_HELPERS_SSE2
+}  // namespace NumHelpersDetail
+
+// codes[i] = code of values[i] for count values, numBits at most the bits of
+// the integer type T. float values to 8 or 16 bit codes use SSE2 kernels
+template <class U, class T>
+void quantizeValues(const U* values, size_t count, U minValue, U maxValue,
+                    int numBits, T* codes) {
+  const U maxCode = U((1 << numBits) - 1);
+  const U scale = maxValue > minValue ? maxCode / (maxValue - minValue) : U(0);
+  parallelFor<size_t>(0, count, [=](size_t begin, size_t end) {
+    NumHelpersDetail::quantize(values + begin, end - begin, minValue, scale,
+                               maxCode, codes + begin);
+  }, c_minQuantizedValuesPerThread);
+}
+
+// values[i] = value of codes[i] for count codes
+template <class T, class U>
+void dequantizeValues(const T* codes, size_t count, U minValue, U maxValue,
+                      int numBits, U* values) {
+  const U step = quantizationStep(minValue, maxValue, numBits);
+  parallelFor<size_t>(0, count, [=](size_t begin, size_t end) {
+    NumHelpersDetail::dequantize(codes + begin, end - begin, minValue, step,
+                                 values + begin);
+  }, c_minQuantizedValuesPerThread);
+}
+
+// The same for count points with coordinate axis in values[axis], each axis
+// with its own range
+template <class U, class T, size_t N>
+void quantizeValues(const std::array<const U*, N>& values, size_t count,
+                    const std::array<U, N>& minValues,
+                    const std::array<U, N>& maxValues, int numBits,
+                    const std::array<T*, N>& codes) {
+  for (size_t axis = 0; axis < N; ++axis) {
+    quantizeValues(values[axis], count, minValues[axis], maxValues[axis],
+                   numBits, codes[axis]);
+  }
+}
+
+template <class T, class U, size_t N>
+void dequantizeValues(const std::array<const T*, N>& codes, size_t count,
+                      const std::array<U, N>& minValues,
+                      const std::array<U, N>& maxValues, int numBits,
+                      const std::array<U*, N>& values) {
+  for (size_t axis = 0; axis < N; ++axis) {
+    dequantizeValues(codes[axis], count, minValues[axis], maxValues[axis],
+                     numBits, values[axis]);
+  }
+}
+
+// Smallest bit depth that keeps every axis within maxError; 0 if none does
+template <class U, size_t N>
+int quantizationBits(const std::array<U, N>& minValues,
+                     const std::array<U, N>& maxValues, U maxError) {
+  int numBits = c_quantizationBitDepths[0];
+  for (size_t axis = 0; axis < N; ++axis) {
+    int axisBits = quantizationBits(minValues[axis], maxValues[axis], maxError);
+    if (axisBits == 0) {
+      return 0;
+    }
+    numBits = numBits > axisBits ? numBits : axisBits;
+  }
+  return numBits;
+}
+
 // Tranpose a matrix given as a plain array.
 // TODO msati3: Move this to matrix class
 template <class T>
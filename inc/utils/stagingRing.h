@@ -0,0 +1,261 @@
+#ifndef _STAGING_RING_H_
+#define _STAGING_RING_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "debug.h"
+
+// Storage and synchronization primitives the staging ring is built on, so the
+// ring logic can run against a CPU mock in tests
+class IStagingBackend {
+ public:
+  typedef uint64_t FenceHandle;  // 0 is never a valid fence
+  static const FenceHandle c_noFence = 0;
+
+  virtual ~IStagingBackend() {}
+
+  // Allocate size bytes of storage that stays mapped (coherently) until
+  // release, and return the mapping, or nullptr if it could not be mapped.
+  // Releases any previous storage
+  virtual unsigned char* allocate(size_t size) = 0;
+  virtual void release() = 0;
+
+  // GL name of the storage to bind for drawing from it; 0 for CPU backends
+  virtual unsigned int bufferName() const = 0;
+
+  // Fence behind all commands issued so far
+  virtual FenceHandle insertFence() = 0;
+  // Non-blocking check whether the fence has signalled
+  virtual bool isFenceSignalled(FenceHandle fence) = 0;
+  // Block until the fence has signalled
+  virtual void waitFence(FenceHandle fence) = 0;
+  virtual void deleteFence(FenceHandle fence) = 0;
+};
+
+// Heap storage with simulated fences, for exercising the ring without a GL
+// context
+class MockStagingBackend : public IStagingBackend {
+ public:
+  // A fence signals once advanceFrame has been called latencyInFrames times
+  // after it was inserted
+  explicit MockStagingBackend(int latencyInFrames = 2)
+      : m_latencyInFrames(latencyInFrames),
+        m_frame(0),
+        m_nextFence(1),
+        m_numAllocations(0),
+        m_numBlockingWaits(0),
+        m_fFailAllocations(false) {}
+
+  unsigned char* allocate(size_t size) override {
+    m_numAllocations++;
+    if (m_fFailAllocations) {
+      m_storage.clear();
+      return nullptr;
+    }
+    m_storage.assign(size, 0);
+    return m_storage.data();
+  }
+  void release() override { m_storage.clear(); }
+  unsigned int bufferName() const override { return 0; }
+
+  FenceHandle insertFence() override {
+    FenceHandle fence = m_nextFence++;
+    m_fenceFrames.push_back(
+        std::make_pair(fence, m_frame + m_latencyInFrames));
+    return fence;
+  }
+  bool isFenceSignalled(FenceHandle fence) override {
+    return signalFrame(fence) <= m_frame;
+  }
+  void waitFence(FenceHandle fence) override {
+    if (!isFenceSignalled(fence)) {
+      // Blocking on a real GPU lets it catch up to the fence
+      m_numBlockingWaits++;
+      m_frame = signalFrame(fence);
+    }
+  }
+  void deleteFence(FenceHandle fence) override {
+    m_fenceFrames.erase(
+        std::remove_if(m_fenceFrames.begin(), m_fenceFrames.end(),
+                       [fence](const std::pair<FenceHandle, int64_t>& entry) {
+                         return entry.first == fence;
+                       }),
+        m_fenceFrames.end());
+  }
+
+  // One frame of simulated GPU progress
+  void advanceFrame() throw() { m_frame++; }
+  // Make later allocations fail, as when a driver cannot map the storage
+  void setFailAllocations(bool fFail) throw() { m_fFailAllocations = fFail; }
+
+  const std::vector<unsigned char>& storage() const throw() {
+    return m_storage;
+  }
+  int numAllocations() const throw() { return m_numAllocations; }
+  // Waits that found their fence still pending, i.e. would have stalled
+  int numBlockingWaits() const throw() { return m_numBlockingWaits; }
+  int numLiveFences() const throw() { return int(m_fenceFrames.size()); }
+
+ private:
+  int64_t signalFrame(FenceHandle fence) const {
+    auto entry =
+        std::find_if(m_fenceFrames.begin(), m_fenceFrames.end(),
+                     [fence](const std::pair<FenceHandle, int64_t>& other) {
+                       return other.first == fence;
+                     });
+    assert(entry != m_fenceFrames.end());
+    return entry->second;
+  }
+
+  int m_latencyInFrames;
+  int64_t m_frame;
+  std::vector<unsigned char> m_storage;
+  std::vector<std::pair<FenceHandle, int64_t>> m_fenceFrames;  // Signal frame
+  FenceHandle m_nextFence;
+  int m_numAllocations;
+  int m_numBlockingWaits;
+  bool m_fFailAllocations;
+};
+
+// Streaming upload ring for per frame data. The storage is split into
+// c_numRegions regions used in turn, one per frame. Each region is fenced
+// after the draws that read it, and is only written again once that fence has
+// signalled, so with the GPU up to two frames behind writes never wait and no
+// upload implicitly synchronizes with the GPU.
+class StagingRing {
+ public:
+  static const int c_numRegions = 3;
+  static const size_t c_alignment = 64;
+
+  struct Allocation {
+    unsigned char* pData;  // Mapped memory to write to
+    size_t offset;         // Offset of pData in the backend's buffer
+  };
+
+  explicit StagingRing(std::unique_ptr<IStagingBackend> pBackend)
+      : m_pBackend(std::move(pBackend)),
+        m_pStorage(nullptr),
+        m_regionSize(0),
+        m_currentRegion(c_numRegions - 1),
+        m_regionUsed(0),
+        m_numStalledFrames(0) {
+    for (int region = 0; region < c_numRegions; ++region) {
+      m_fences[region] = IStagingBackend::c_noFence;
+    }
+  }
+
+  ~StagingRing() {
+    for (int region = 0; region < c_numRegions; ++region) {
+      waitForRegion(region);
+    }
+    m_pBackend->release();
+  }
+
+  StagingRing(const StagingRing&) = delete;
+  StagingRing& operator=(const StagingRing&) = delete;
+
+  // Move to the next region, waiting for the GPU only if it is still reading
+  // it, and make sure regions hold at least frameSize bytes. Growing the
+  // storage waits for all regions, so callers should pass their largest
+  // frame size from the start when they know it. Returns false, without
+  // moving on, if the storage could not be mapped; callers then have to
+  // upload another way, and the next beginFrame tries to map again
+  bool beginFrame(size_t frameSize);
+
+  // Carve size bytes out of the current region. The region must have been
+  // sized for it in beginFrame
+  Allocation allocate(size_t size);
+
+  // Fence the current region behind the commands issued so far. Call after
+  // every draw that reads it; only the last fence is kept
+  void fenceCurrentRegion();
+
+  unsigned int bufferName() const { return m_pBackend->bufferName(); }
+  size_t regionSize() const throw() { return m_regionSize; }
+  int currentRegion() const throw() { return m_currentRegion; }
+
+  // Frames whose beginFrame had to wait for the GPU
+  int numStalledFrames() const throw() { return m_numStalledFrames; }
+
+  IStagingBackend& backend() throw() { return *m_pBackend; }
+
+ private:
+  void waitForRegion(int region) {
+    IStagingBackend::FenceHandle& fence = m_fences[region];
+    if (fence != IStagingBackend::c_noFence) {
+      m_pBackend->waitFence(fence);
+      m_pBackend->deleteFence(fence);
+      fence = IStagingBackend::c_noFence;
+    }
+  }
+
+  std::unique_ptr<IStagingBackend> m_pBackend;
+  unsigned char* m_pStorage;
+  size_t m_regionSize;
+  int m_currentRegion;
+  size_t m_regionUsed;
+  IStagingBackend::FenceHandle m_fences[c_numRegions];
+  int m_numStalledFrames;
+};
+
+// Round size up to the ring's allocation alignment
+inline size_t alignToStagingRing(size_t size) {
+  const size_t mask = StagingRing::c_alignment - 1;
+  return (size + mask) & ~mask;
+}
+
+inline bool StagingRing::beginFrame(size_t frameSize) {
+  frameSize = alignToStagingRing(frameSize);
+  if (frameSize > m_regionSize) {
+    // The GPU may still read any region from the old storage
+    for (int region = 0; region < c_numRegions; ++region) {
+      waitForRegion(region);
+    }
+    // Leave headroom so slowly growing frames do not reallocate every time
+    m_regionSize = std::max(frameSize, m_regionSize + m_regionSize / 2);
+    m_pStorage = m_pBackend->allocate(c_numRegions * m_regionSize);
+    if (m_pStorage == nullptr) {
+      m_regionSize = 0;
+      return false;
+    }
+    LOG("Staging ring resized to " << c_numRegions << " x " << m_regionSize
+                                   << " bytes",
+        DEBUG_LEVELS::VERBOSE);
+  }
+
+  m_currentRegion = (m_currentRegion + 1) % c_numRegions;
+  m_regionUsed = 0;
+  IStagingBackend::FenceHandle fence = m_fences[m_currentRegion];
+  if (fence != IStagingBackend::c_noFence &&
+      !m_pBackend->isFenceSignalled(fence)) {
+    m_numStalledFrames++;
+  }
+  waitForRegion(m_currentRegion);
+  return true;
+}
+
+inline StagingRing::Allocation StagingRing::allocate(size_t size) {
+  size = alignToStagingRing(size);
+  assert(m_pStorage != nullptr && m_regionUsed + size <= m_regionSize);
+  Allocation allocation;
+  allocation.offset = m_currentRegion * m_regionSize + m_regionUsed;
+  allocation.pData = m_pStorage + allocation.offset;
+  m_regionUsed += size;
+  return allocation;
+}
+
+inline void StagingRing::fenceCurrentRegion() {
+  IStagingBackend::FenceHandle& fence = m_fences[m_currentRegion];
+  if (fence != IStagingBackend::c_noFence) {
+    m_pBackend->deleteFence(fence);
+  }
+  fence = m_pBackend->insertFence();
+}
+
+#endif  //_STAGING_RING_H_
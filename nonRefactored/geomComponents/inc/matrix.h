@@ -1,11 +1,29 @@
 #ifndef _MATRIX_H_
 #define _MATRIX_H_
 
+#include <cstddef>
+#include "functionHelpers.h"
+
+// 4x4 matrix acting on column vectors, stored row-major so that products and
+// batched transforms work on whole SSE registers. Rows are 16 byte aligned
+// where the allocation allows, but are loaded unaligned since matrices inside
+// heap allocated objects need not be.
+// The matrix tracks what kind of transform it holds, so that rigid and affine transforms are
+// composed and inverted without the general 4x4 cost.
 class Matrix
 {
 public:
+  // Ordered from most to least specific; a product is of the larger kind of its factors
+  enum class Kind
+  {
+    RIGID,   // Rotation and translation
+    AFFINE,  // Any 3x3 part and translation, bottom row (0, 0, 0, 1)
+    GENERAL
+  };
+
   Matrix() { setZero();  }
   Matrix(const float matrix[][4]);
+  Matrix(const float matrix[][4], Kind kind); //Caller guarantees the matrix is of the given kind
   Matrix(const Matrix& other);
   Matrix(const Vector<float>& x, const Vector<float>& y, const Vector<float>& z); //Create rotation matrix with given basis
 
@@ -15,18 +33,56 @@ public:
 
   void rotate(const Vector<float>& axis, float angle);
   void translate(const Vector<float>& vector);
+  void scale(float factor) throw();
   void invert();
+  Kind kind() const throw() { return m_kind; }
 
   Matrix operator*(const Matrix& matrix2) const throw();
-  const float* getAsGLArray() throw();
+  // Column-major elements, cached until the matrix changes
+  const float* getAsGLArray() const throw();
   Point<float> transformPoint(const Point<float>& untransformed) const throw();
   Point<float> untransformPoint(const Point<float>& transformed) const throw();
   Vector<float> transformVector(const Vector<float>& untransformed) const throw();
   Vector<float> untransformVector(const Vector<float>& transformed) const throw();
 
+  // Batched transforms of count packed xyz triples from pIn to pOut, which may be the same array.
+  // Points are taken with w = 1 and vectors with w = 0, and the bottom row is ignored as for any
+  // affine transform. Large batches are split across worker threads.
+  void transformPoints(const float* pIn, float* pOut, size_t count) const throw();
+  void transformVectors(const float* pIn, float* pOut, size_t count) const throw();
+  // Same for points whose coordinates are in separate arrays, such as a PointCloud's
+  void transformPoints(float* pX, float* pY, float* pZ, size_t count) const throw();
+  // Same for the points in [begin, end) of a random access range, in place
+  template <typename Iterator>
+  void transformPoints(Iterator begin, Iterator end) const;
+
 private:
-  float m_elements[4][4];
-  float m_elementsTransposed[4][4];
+  static const size_t c_minPointsPerThread = 1 << 15;
+
+  void invertGeneral();
+
+  alignas(16) float m_elements[4][4];
+  Kind m_kind;
+  alignas(16) mutable float m_elementsTransposed[4][4];
+  mutable bool m_fTransposedValid;
 };
 
-#endif //_MATRIX_H_
\ No newline at end of file
+template <typename Iterator>
+void Matrix::transformPoints(Iterator begin, Iterator end) const
+{
+  const float (&m)[4][4] = m_elements;
+  parallelFor<ptrdiff_t>(0, end - begin, [&m, begin](ptrdiff_t first, ptrdiff_t last)
+  {
+    for (Iterator point = begin + first; point != begin + last; ++point)
+    {
+      float x = point->x();
+      float y = point->y();
+      float z = point->z();
+      point->set(m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3],
+                 m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3],
+                 m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3]);
+    }
+  }, ptrdiff_t(c_minPointsPerThread));
+}
+
+#endif //_MATRIX_H_
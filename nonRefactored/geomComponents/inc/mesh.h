@@ -11,14 +11,26 @@
 #include <boost/dynamic_bitset.hpp>
 
 #include "point.h"
+#include "functionHelpers.h"
+#include "hashHelpers.h"
+#include "packedAttributes.h"
 #include "sceneGraph.h"
+#include "glStagingBackend.h"
+#include "vertexWelding.h"
 #include "geometryHelpers.h"
 
 #undef min
 #undef max
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <limits>
 #include <map>
+#include <thread>
+#include <unordered_map>
 
 const int MAX_VALENCE = 100;
 
@@ -36,6 +48,15 @@ class IInteractableMesh : public ICommandable,
   virtual Point<float> boundingBoxCenter() const throw() = 0;
   virtual Point<float> boundingBoxSize() const throw() = 0;
   virtual Point<float> lookAtLocation() const throw() = 0;
+
+  // Changes whenever the geometry, connectivity or marker colours change, so
+  // copies such as the LOD cache can tell when they are stale
+  virtual unsigned int revision() const throw() = 0;
+  // Positions as x y z floats per vertex, three vertex indices per triangle
+  // and the displayed RGBA colour of each triangle
+  virtual void exportFlatGeometry(std::vector<float>& positions,
+                                  std::vector<unsigned int>& indices,
+                                  std::vector<uint8_t>& triangleColors) = 0;
 };
 
 const int c_numTriangleMarkers = 10;
@@ -99,16 +120,52 @@ class Mesh : public IInteractableMesh {
   std::vector<Vector<U>> m_normals;
   std::vector<bool> m_fVRemoved;
 
+  // Derived data is materialized on first use, so that batch tools that never
+  // draw or colour anything do not pay for it. Edits invalidate the parts
+  // they make stale.
+  enum DerivedData : unsigned int {
+    DERIVED_NORMALS = 1 << 0,
+    DERIVED_MARKERS = 1 << 1,  // m_tm, m_vm and m_fVRemoved
+    DERIVED_BOUNDING_BOX = 1 << 2,
+    DERIVED_ALL = (1 << 3) - 1
+  };
+  mutable unsigned int m_validDerivedData;
+  unsigned int m_revision;
+
  private:
   GLuint m_vertexVBO;
   GLuint m_colorVBO;
-  GLuint m_edgeVBO;
+  GLuint m_edgeIBO;  // Unique edges, indexing the per corner m_vertexVBO
+  GLsizei m_numEdgeIndices;
+  U m_featureEdgeAngle;  // Radians; 0 draws every edge
+  AttributePrecision m_attributePrecision;
+  // Layout of the buffers last written by updateGeometryVBO, which is what
+  // draw binds until the next upload
+  AttributePrecision m_uploadedPrecision;
+  PositionDequantization<U> m_positionDequantization;  // For PACKED
   GLuint m_normalVBO;
 
+  // Dynamic updates stream into a persistently mapped ring instead of
+  // reallocating the VBOs. The offsets locate the last update in the ring's
+  // buffer while m_fStreamedGeometry is set. If the ring cannot be mapped,
+  // m_fStagingRingFailed sends later updates to the VBOs.
+  std::unique_ptr<StagingRing> m_pStagingRing;
+  bool m_fStreamedGeometry;
+  bool m_fStagingRingFailed;
+  size_t m_streamedVertexOffset;
+  size_t m_streamedNormalOffset;
+  size_t m_streamedEdgeOffset;
+
   bool m_fDrawPlane;
 
-  Point<U> m_boxCenter;
-  BoundingBox<U> m_boundingBox;
+  mutable Point<U> m_boxCenter;
+  mutable BoundingBox<U> m_boundingBox;
+  // Number of vertices on each box face, low x y z then high x y z. A lower
+  // bound: 0 also stands for unknown, for boxes not computed from the vertices
+  mutable std::array<int, 6> m_boxFaceCounts;
+
+  // Open edges of the current construction session, null outside of one
+  std::unique_ptr<std::unordered_map<uint64_t, CIndex>> m_pOpenEdges;
   QuadricWrapper m_pCornerQuadric;
   QuadricWrapper m_pVertexQuadric;
 
@@ -117,6 +174,29 @@ class Mesh : public IInteractableMesh {
   bool m_fShowCorners;
   bool m_fShowNormals;
 
+  U m_weldEpsilon;  // Loaders weld vertices closer than this if positive
+  bool m_fUseDerivedDataCache;
+  boost::filesystem::path m_derivedDataCacheDirectory;  // Empty: next to mesh
+
+  // Layout of a derived data sidecar. The O table (nc indices) and the
+  // normals (3 * nv scalars) follow at the given byte offsets, so the file
+  // can be mapped and copied from directly.
+  struct DerivedDataCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t indexSize;
+    uint32_t scalarSize;
+    uint32_t reserved;
+    uint64_t contentHash;
+    uint64_t nv;
+    uint64_t nc;
+    uint64_t oTableOffset;
+    uint64_t normalsOffset;  // 0 if the normals were not cached
+    U boxLow[3];
+    U boxHigh[3];
+  };
+  static const uint32_t c_derivedDataCacheVersion = 2;
+
   void setGTable(VIndex index, const Point<U>& point);
   void setVTable(CIndex index, VIndex value);
   void setOpposites(CIndex index1, CIndex index2);
@@ -125,6 +205,34 @@ class Mesh : public IInteractableMesh {
  protected:
   virtual void populateAuxMembers();
 
+  void ensureNormals() {
+    if (!(m_validDerivedData & DERIVED_NORMALS)) {
+      populateNormals();
+    }
+  }
+
+  void ensureMarkers() {
+    if (!(m_validDerivedData & DERIVED_MARKERS)) {
+      m_vm.assign(m_nv, 0);
+      m_fVRemoved.assign(m_nv, false);
+      m_tm.assign(m_nt, 0);
+      m_validDerivedData |= DERIVED_MARKERS;
+    }
+    ensureColorMap();
+  }
+
+  void ensureColorMap() {
+    if (!m_pColorMap) {
+      setColorMap();
+    }
+  }
+
+  void ensureBoundingBox() const {
+    if (!(m_validDerivedData & DERIVED_BOUNDING_BOX)) {
+      computeBox();
+    }
+  }
+
   virtual void setColorMap() {
     COLORS colorMap[] = {COLORS::RED,   COLORS::GREEN,   COLORS::BLUE,
                          COLORS::CYAN,  COLORS::MAGENTA, COLORS::YELLOW,
@@ -144,6 +252,15 @@ class Mesh : public IInteractableMesh {
   Mesh& swap(Mesh& other);
   Mesh& operator=(Mesh other);
 
+  // Mark derived data (a combination of DerivedData flags) as stale, to be
+  // recomputed on next use
+  void invalidateDerivedData(unsigned int derivedData) throw() {
+    m_validDerivedData &= ~derivedData;
+    touch();
+  }
+
+  unsigned int revision() const throw() override { return m_revision; }
+
 #pragma region InitMesh
   Point<U> centerBoundingBox() const throw();
   void init() override;
@@ -165,6 +282,11 @@ class Mesh : public IInteractableMesh {
   CIndex offset(CIndex c) const throw();
   const Point<U>& g(CIndex c) const throw();
   const Point<U>& geom(VIndex v) const throw();
+  void setGeom(VIndex v, const Point<U>& point) {
+    updateBoundingBox(&m_GTable[v], &point);
+    m_GTable[v] = point;
+    invalidateDerivedData(DERIVED_NORMALS);
+  }
   CIndex c(TIndex tIndex, VIndex vIndex) const throw();
 
 #pragma region MiscHelpers
@@ -569,58 +691,75 @@ class Mesh : public IInteractableMesh {
 #pragma endregion VertexIterator
 
   void computeO() {
-    std::vector<CIndex> valence(m_nv);
-
-    for (VIndex i = VIndex(0); i < m_nv; i++) {
-      valence[i] = CIndex(0);
+    std::vector<T> firstIncidentCorner;
+    std::vector<CIndex> incidentCorners;
+    computeIncidentCorners(firstIncidentCorner, incidentCorners);
+    computeOFromIncidentCorners(firstIncidentCorner, incidentCorners);
+  }
+
+  // Counting sort of the corners by vertex: the corners incident on v are
+  // incidentCorners[firstIncidentCorner[v] .. firstIncidentCorner[v + 1])
+  void computeIncidentCorners(std::vector<T>& firstIncidentCorner,
+                              std::vector<CIndex>& incidentCorners) const {
+    firstIncidentCorner.assign(m_nv + 1, 0);
+    for (T cIndex = 0; cIndex < m_nc; ++cIndex) {
+      firstIncidentCorner[m_VTable[cIndex] + 1]++;
     }
-    for (CIndex i = CIndex(0); i < m_nc; i++) {
-      valence[v(i)]++;
+    for (T vIndex = 0; vIndex < m_nv; ++vIndex) {
+      firstIncidentCorner[vIndex + 1] += firstIncidentCorner[vIndex];
     }
 
-    std::vector<CIndex> firstIncidentCorner(m_nv);
-    int runningFirstIncidentCorner = 0;
-
-    for (VIndex i = VIndex(0); i < m_nv; i++) {
-      firstIncidentCorner[i] = runningFirstIncidentCorner;
-      runningFirstIncidentCorner += valence[i];
-    };  // head of list of incident corners
-
-    for (VIndex i = VIndex(0); i < m_nv; i++) {
-      valence[i] = CIndex(0);  // valences wil be reused to track how many
-                               // incident corners were encountered for each
-                               // vertex
+    std::vector<T> fill(firstIncidentCorner.begin(),
+                        firstIncidentCorner.end() - 1);
+    incidentCorners.resize(m_nc);
+    for (T cIndex = 0; cIndex < m_nc; ++cIndex) {
+      incidentCorners[fill[m_VTable[cIndex]]++] = CIndex(cIndex);
     }
+  }
 
-    std::vector<CIndex> C(m_nc);
-    std::for_each(
-        beginCornerIterator(), endCornerIterator(),
-        [this, &C, &firstIncidentCorner, &valence](const CIndex& corner) {
-          C[firstIncidentCorner[v(corner)] + valence[v(corner)]++] =
-              corner;  // for each vertex: the list of val[v] incident corners
-                       // starts at C[fic[v]]
-          m_OTable[corner] = -1;
-        });
-
-    for (VIndex i = VIndex(0); i < m_nv; i++) {
-      for (CIndex c1 = firstIncidentCorner[i];
-           c1 < firstIncidentCorner[i] + valence[i] - 1; c1++) {
-        for (CIndex c2 = CIndex(c1 + 1);
-             c2 < firstIncidentCorner[i] + valence[i]; c2++) {
-          // for each pair (C[a],C[b[]) of its incident corners
-          if (v(n(C[c1])) == v(p(C[c2]))) {
-            m_OTable[p(C[c1])] = n(C[c2]);
-            m_OTable[n(C[c2])] = p(C[c1]);
-          }
-          // if C[a] follows C[b] around v, then p(C[a]) and n(C[b]) are
-          // opposite
-          if (v(n(C[c2])) == v(p(C[c1]))) {
-            m_OTable[p(C[c2])] = n(C[c1]);
-            m_OTable[n(C[c1])] = p(C[c2]);
+  // For each pair (a, b) of corners around a vertex, if b precedes a then p(a)
+  // and n(b) are opposite. Only O[p(a)] is written while visiting v(a), so
+  // every entry has a single writer and vertices are matched in parallel.
+  void computeOFromIncidentCorners(
+      const std::vector<T>& firstIncidentCorner,
+      const std::vector<CIndex>& incidentCorners) {
+    m_OTable.resize(m_nc);
+    parallelFor<T>(0, m_nv, [&](T begin, T end) {
+      for (T vIndex = begin; vIndex < end; ++vIndex) {
+        T fanBegin = firstIncidentCorner[vIndex];
+        T fanEnd = firstIncidentCorner[vIndex + 1];
+        for (T i = fanBegin; i < fanEnd; ++i) {
+          CIndex a = incidentCorners[i];
+          VIndex edgeEnd = v(n(a));
+          m_OTable[p(a)] = -1;
+          for (T j = fanBegin; j < fanEnd; ++j) {
+            CIndex b = incidentCorners[j];
+            if (b != a && v(p(b)) == edgeEnd) {
+              m_OTable[p(a)] = n(b);
+            }
           }
         }
       }
-    }
+    });
+  }
+
+  // Area weighted vertex normals, gathered over each vertex's corners
+  void populateNormalsFromIncidentCorners(
+      const std::vector<T>& firstIncidentCorner,
+      const std::vector<CIndex>& incidentCorners) {
+    m_normals.resize(m_nv);
+    parallelFor<T>(0, m_nv, [&](T begin, T end) {
+      for (T vIndex = begin; vIndex < end; ++vIndex) {
+        Vector<U> normal(0, 0, 0);
+        for (T i = firstIncidentCorner[vIndex];
+             i < firstIncidentCorner[vIndex + 1]; ++i) {
+          normal.add(triangleNormal(incidentCorners[i], false));
+        }
+        normal.normalize();
+        m_normals[vIndex] = normal;
+      }
+    });
+    m_validDerivedData |= DERIVED_NORMALS;
   }
 
   Vector<U> triangleNormal(CIndex corner, bool fNormalized) const {
@@ -632,9 +771,7 @@ class Mesh : public IInteractableMesh {
   }
 
   void populateNormals() {
-    std::for_each(
-        cBeginVertexIterator(), cEndVertexIterator(),
-        [this](VIndex vIndex) { m_normals.push_back(Vector<float>(0, 0, 0)); });
+    m_normals.assign(m_nv, Vector<U>(0, 0, 0));
 
     std::for_each(cBeginCornerIterator(), cEndCornerIterator(),
                   [this](CIndex cIndex) {
@@ -643,9 +780,11 @@ class Mesh : public IInteractableMesh {
 
     std::for_each(cBeginVertexIterator(), cEndVertexIterator(),
                   [this](VIndex vIndex) { m_normals[vIndex].normalize(); });
+    m_validDerivedData |= DERIVED_NORMALS;
   }
 
   Vector<U> vNormal(CIndex corner) {
+    ensureNormals();
     return m_normals[v(corner)];
     /*Vector<U> normal;
     std::for_each( beginSwingIterator( corner ), endSwingIterator( corner ), [
@@ -656,8 +795,12 @@ class Mesh : public IInteractableMesh {
     return normal;*/
   }
 
-  void computeBox() {
+  void computeBox() const {
     // computes center of the bounding box
+    if (m_nv == 0) {
+      setBoundingBox(Point<U>(0, 0, 0), Point<U>(0, 0, 0), false);
+      return;
+    }
     Point<U> lowBox = m_GTable[0];
     Point<U> highBox = m_GTable[0];
     std::for_each(
@@ -671,39 +814,181 @@ class Mesh : public IInteractableMesh {
           highBox.set(1, std::max<U>(highBox.y(), m_GTable[vIndex].y()));
           highBox.set(2, std::max<U>(highBox.z(), m_GTable[vIndex].z()));
         });
-    m_boxCenter = Point<U>(lowBox, highBox);
-    m_boundingBox = BoundingBox<U>(lowBox, highBox);
+    setBoundingBox(lowBox, highBox, true);
   };
 
+ private:
+  static U axisValue(const Point<U>& point, int axis) {
+    return axis == 0 ? point.x() : (axis == 1 ? point.y() : point.z());
+  }
+
+  // Set the box and mark it valid. Face counts are recounted if fCountFaces,
+  // and otherwise left unknown.
+  void setBoundingBox(const Point<U>& low, const Point<U>& high,
+                      bool fCountFaces) const {
+    m_boxCenter = Point<U>(low, high);
+    m_boundingBox = BoundingBox<U>(low, high);
+    m_boxFaceCounts.fill(0);
+    if (fCountFaces) {
+      for (T vIndex = 0; vIndex < m_nv; ++vIndex) {
+        for (int axis = 0; axis < 3; ++axis) {
+          U value = axisValue(m_GTable[vIndex], axis);
+          m_boxFaceCounts[axis] += value == axisValue(low, axis);
+          m_boxFaceCounts[3 + axis] += value == axisValue(high, axis);
+        }
+      }
+    }
+    m_validDerivedData |= DERIVED_BOUNDING_BOX;
+  }
+
+  // Keep the box current as one vertex moves from pOldPoint to pNewPoint,
+  // either of which may be null for added or removed vertices. The box grows
+  // right away; it only needs a full recompute, done lazily, once no vertex
+  // is known to remain on a face that a vertex has left.
+  void updateBoundingBox(const Point<U>* pOldPoint, const Point<U>* pNewPoint) {
+    if (!(m_validDerivedData & DERIVED_BOUNDING_BOX)) {
+      return;
+    }
+    Point<U> low = m_boundingBox.low();
+    Point<U> high = m_boundingBox.high();
+    bool fGrown = false;
+    for (int axis = 0; axis < 3; ++axis) {
+      int& lowCount = m_boxFaceCounts[axis];
+      int& highCount = m_boxFaceCounts[3 + axis];
+      if (pOldPoint != nullptr) {
+        U oldValue = axisValue(*pOldPoint, axis);
+        lowCount -= oldValue == axisValue(low, axis);
+        highCount -= oldValue == axisValue(high, axis);
+      }
+      if (pNewPoint != nullptr) {
+        U newValue = axisValue(*pNewPoint, axis);
+        if (newValue < axisValue(low, axis)) {
+          low.set(axis, newValue);
+          lowCount = 1;
+          fGrown = true;
+        } else {
+          lowCount += newValue == axisValue(low, axis);
+        }
+        if (newValue > axisValue(high, axis)) {
+          high.set(axis, newValue);
+          highCount = 1;
+          fGrown = true;
+        } else {
+          highCount += newValue == axisValue(high, axis);
+        }
+      }
+      if (lowCount <= 0 || highCount <= 0) {
+        invalidateDerivedData(DERIVED_BOUNDING_BOX);
+        return;
+      }
+    }
+    if (fGrown) {
+      m_boxCenter = Point<U>(low, high);
+      m_boundingBox = BoundingBox<U>(low, high);
+    }
+  }
+
+  // Call function for each corner around v(corner), walking both ways from
+  // corner if the fan is open
+  template <typename Function>
+  void forEachCornerAround(CIndex corner, Function const& function) const {
+    CIndex current = corner;
+    do {
+      function(current);
+      CIndex opposite = o(n(current));
+      if (opposite == -1) {
+        // Open fan: visit the rest from the other side
+        for (current = corner; o(p(current)) != -1;) {
+          current = p(o(p(current)));
+          function(current);
+        }
+        return;
+      }
+      current = n(opposite);
+    } while (current != corner);
+  }
+
+  void recomputeNormal(CIndex corner) {
+    Vector<U> normal(0, 0, 0);
+    forEachCornerAround(corner, [this, &normal](CIndex cIndex) {
+      normal.add(triangleNormal(cIndex, false));
+    });
+    normal.normalize();
+    m_normals[v(corner)] = normal;
+  }
+
+ public:
+  // Recompute the normals of v(corner) and of its one-ring neighbours, the
+  // only ones that change when v(corner) moves or its fan is edited
+  void updateNormalsAround(CIndex corner) {
+    m_normals.resize(m_nv);
+    recomputeNormal(corner);
+    forEachCornerAround(corner, [this](CIndex cIndex) {
+      recomputeNormal(n(cIndex));
+      recomputeNormal(p(cIndex));
+    });
+  }
+
+  // Move v(corner) to newVertex, keeping normals current on its one-ring
+  // instead of invalidating them
+  void replaceVertex(CIndex corner, const Point<U>& newVertex) {
+    updateBoundingBox(&m_GTable[v(corner)], &newVertex);
+    m_GTable[v(corner)] = newVertex;
+    touch();
+    if (m_validDerivedData & DERIVED_NORMALS) {
+      updateNormalsAround(corner);
+    }
+  }
+
+  // Apply an affine transform to every vertex in one batched pass. Normals
+  // and the bounding box are recomputed when next needed
+  void transformGeometry(const Matrix& matrix) {
+    matrix.transformPoints(m_GTable.begin(), m_GTable.end());
+    invalidateDerivedData(DERIVED_NORMALS | DERIVED_BOUNDING_BOX);
+  }
+
+  // Overwrite the position of every vertex from x, y and z arrays in one
+  // parallel pass. Normals and the bounding box are recomputed when next needed
+  void setGeometry(const U* x, const U* y, const U* z) {
+    parallelFor<T>(0, m_nv, [&](T begin, T end) {
+      for (T vIndex = begin; vIndex < end; ++vIndex) {
+        m_GTable[vIndex] = Point<U>(x[vIndex], y[vIndex], z[vIndex]);
+      }
+    });
+    invalidateDerivedData(DERIVED_NORMALS | DERIVED_BOUNDING_BOX);
+  }
+
   void centerMesh() {
-    std::for_each(cBeginVertexIterator(), cEndVertexIterator(),
-                  [this](VIndex vIndex) {
-                    m_GTable[vIndex] = m_GTable[vIndex] - m_boxCenter;
-                  });
+    ensureBoundingBox();
+    Matrix translation;
+    translation.setIdentity();
+    translation.translate(Vector<float>(-m_boxCenter.x(), -m_boxCenter.y(),
+                                        -m_boxCenter.z()));
+    translation.transformPoints(m_GTable.begin(), m_GTable.end());
     computeBox();
   }
 
   void scaleMesh(float desiredBoundingBoxSize) {
+    ensureBoundingBox();
     float boundingBoxSize =
         std::max<float>(m_boundingBox.high().x() - m_boundingBox.low().x(),
                         m_boundingBox.high().y() - m_boundingBox.low().y());
     boundingBoxSize = std::max<float>(
         m_boundingBox.high().z() - m_boundingBox.low().z(), boundingBoxSize);
-    float scale = desiredBoundingBoxSize / boundingBoxSize;
-    std::for_each(cBeginVertexIterator(), cEndVertexIterator(),
-                  [this, &scale](VIndex vIndex) {
-                    m_GTable[vIndex].set(scale * m_GTable[vIndex].x(),
-                                         scale * m_GTable[vIndex].y(),
-                                         scale * m_GTable[vIndex].z());
-                  });
+    Matrix scaling;
+    scaling.setIdentity();
+    scaling.scale(desiredBoundingBoxSize / boundingBoxSize);
+    scaling.transformPoints(m_GTable.begin(), m_GTable.end());
     computeBox();
   }
 
   Point<float> boundingBoxCenter() const throw() override {
+    ensureBoundingBox();
     return m_boxCenter;
   }
 
   Point<float> boundingBoxSize() const throw() override {
+    ensureBoundingBox();
     return Point<float>(m_boundingBox.high() - m_boundingBox.low());
   }
 
@@ -757,8 +1042,16 @@ class Mesh : public IInteractableMesh {
 
 #pragma region LOADING AND SAVING
   // TODO msati3: Push this out to a builder class sometime later
-  void loadMeshVTS(const boost::filesystem::path& path, int scale = 1) {
+  // Normals are otherwise built on first use. With fEagerNormals they are
+  // built while the O table is computed, which suits viewers that draw the
+  // mesh right away.
+  // If the derived data cache is enabled, the O table and bounding box come
+  // from a sidecar when its content hash matches, and the sidecar is
+  // (re)written otherwise. Normals are cached only if they were built eagerly.
+  void loadMeshVTS(const boost::filesystem::path& path, int scale = 1,
+                   bool fEagerNormals = false) {
     LOGPERF;
+    invalidateDerivedData(DERIVED_ALL);
     boost::iostreams::mapped_file_source file(path);
     const char* currentPtr = file.data();
     char* end = '\0';
@@ -767,12 +1060,21 @@ class Mesh : public IInteractableMesh {
     m_GTable.reserve(m_nv);
     currentPtr = end + 1;
 
+    // The bounding box is tracked while parsing, so that normalization does
+    // not need its own pass over m_GTable
+    std::array<U, 3> low;
+    std::array<U, 3> high;
+    low.fill(std::numeric_limits<U>::max());
+    high.fill(std::numeric_limits<U>::lowest());
+
     T currentLine = 0;
     Point<U> readPoint;
     while (errno == 0 && (currentLine++ != m_nv)) {
       for (int i = 0; i < 3; i++) {
-        U readValue = strtoT<U>(currentPtr, &end);
-        readPoint.set(i, scale * readValue);
+        U readValue = scale * strtoT<U>(currentPtr, &end);
+        readPoint.set(i, readValue);
+        low[i] = std::min(low[i], readValue);
+        high[i] = std::max(high[i], readValue);
         currentPtr = end + 1;
       }
       m_GTable.emplace_back(readPoint);
@@ -793,13 +1095,321 @@ class Mesh : public IInteractableMesh {
       }
     }
 
-    computeBox();
-    centerMesh();
-    scaleMesh(500);
-    computeO();
+    if (m_nv > 0) {
+      normalizeGeometry(Point<U>(low[0], low[1], low[2]),
+                        Point<U>(high[0], high[1], high[2]), 500);
+    }
+    if (m_weldEpsilon > 0) {
+      weldVertices(m_weldEpsilon);
+    }
+
+    uint64_t hash = 0;
+    boost::filesystem::path cachePath;
+    bool fCacheHit = false;
+    if (m_fUseDerivedDataCache) {
+      hash = contentHash();
+      cachePath = derivedDataCachePath(path, hash);
+      fCacheHit = loadDerivedDataCache(cachePath, hash);
+    }
+
+    if (!fCacheHit) {
+      if (fEagerNormals) {
+        // Normals only need the V and G tables, so they are built while the O
+        // table is computed on another thread
+        std::thread oppositesThread([this]() { computeO(); });
+        populateNormals();
+        oppositesThread.join();
+      } else {
+        computeO();
+      }
+      if (m_fUseDerivedDataCache) {
+        saveDerivedDataCache(cachePath, hash);
+      }
+    }
     populateAuxMembers();
   }
 
+  // Have loaders weld vertices within epsilon of each other, in the units of
+  // the normalized geometry, before building the O table. 0 disables welding.
+  void setWeldEpsilon(U epsilon) throw() { m_weldEpsilon = epsilon; }
+
+  // Merge vertices within epsilon of each other, such as the duplicated
+  // corners of a triangle soup, so that computeO can find opposites. Each
+  // cluster keeps the position of its lowest indexed vertex, and vertices keep
+  // their relative order. Triangles that become degenerate are dropped. The O
+  // table is left stale. Returns the number of vertices merged away.
+  T weldVertices(U epsilon) {
+    LOGPERF;
+    std::vector<T> vertexMap;
+    T numClusters = computeWeldRepresentatives(m_GTable, epsilon, vertexMap);
+    T numMerged = m_nv - numClusters;
+    if (numMerged == 0) {
+      return 0;
+    }
+
+    // Compact the G table in place; representatives come first in their
+    // cluster, so vertexMap[representative] is final before it is read
+    T numKept = 0;
+    for (T vIndex = 0; vIndex < m_nv; ++vIndex) {
+      if (vertexMap[vIndex] == vIndex) {
+        m_GTable[numKept] = m_GTable[vIndex];
+        vertexMap[vIndex] = numKept++;
+      } else {
+        vertexMap[vIndex] = vertexMap[vertexMap[vIndex]];
+      }
+    }
+    m_GTable.resize(numKept);
+    m_nv = VIndex(numKept);
+
+    parallelFor<T>(0, m_nc, [this, &vertexMap](T begin, T end) {
+      for (T cIndex = begin; cIndex < end; ++cIndex) {
+        m_VTable[cIndex] = VIndex(vertexMap[m_VTable[cIndex]]);
+      }
+    });
+
+    T numTriangles = 0;
+    for (T tIndex = 0; tIndex < m_nt; ++tIndex) {
+      VIndex a = m_VTable[3 * tIndex];
+      VIndex b = m_VTable[3 * tIndex + 1];
+      VIndex c = m_VTable[3 * tIndex + 2];
+      if (a != b && b != c && c != a) {
+        m_VTable[3 * numTriangles] = a;
+        m_VTable[3 * numTriangles + 1] = b;
+        m_VTable[3 * numTriangles + 2] = c;
+        numTriangles++;
+      }
+    }
+    LOG("Welded " << numMerged << " vertices, dropped "
+                  << m_nt - numTriangles << " degenerate triangles",
+        DEBUG_LEVELS::LOW);
+    m_nt = TIndex(numTriangles);
+    m_nc = CIndex(3 * numTriangles);
+    m_VTable.resize(m_nc);
+    m_OTable.resize(m_nc);
+
+    invalidateDerivedData(DERIVED_ALL);
+    return numMerged;
+  }
+
+  // Cache the O table, normals and bounding box built by loadMeshVTS in a
+  // sidecar file, keyed by a hash of the V and G tables. By default the
+  // sidecar sits next to the mesh as <mesh>.vtscache; with a cache directory
+  // it is stored there as <hash>.vtscache. Off by default.
+  void setUseDerivedDataCache(
+      bool fUse,
+      const boost::filesystem::path& cacheDirectory = boost::filesystem::path()) {
+    m_fUseDerivedDataCache = fUse;
+    m_derivedDataCacheDirectory = cacheDirectory;
+  }
+
+  // Hash of the V and G tables. Blocks are hashed in parallel and combined in
+  // order, so the result does not depend on the number of threads
+  uint64_t contentHash() const {
+    static_assert(sizeof(Point<U>) == 3 * sizeof(U), "Point must be packed");
+    static_assert(sizeof(VIndex) == sizeof(T), "VIndex must be packed");
+    const T c_blockSize = 1 << 16;
+    T numGBlocks = (m_nv + c_blockSize - 1) / c_blockSize;
+    T numVBlocks = (m_nc + c_blockSize - 1) / c_blockSize;
+    std::vector<uint64_t> blockHashes(numGBlocks + numVBlocks);
+
+    parallelFor<T>(0, numGBlocks + numVBlocks, [&](T begin, T end) {
+      for (T block = begin; block < end; ++block) {
+        if (block < numGBlocks) {
+          T first = block * c_blockSize;
+          T count = std::min<T>(c_blockSize, m_nv - first);
+          blockHashes[block] = hashBytes(m_GTable.data() + first,
+                                         count * sizeof(Point<U>), block);
+        } else {
+          T first = (block - numGBlocks) * c_blockSize;
+          T count = std::min<T>(c_blockSize, m_nc - first);
+          blockHashes[block] = hashBytes(m_VTable.data() + first,
+                                         count * sizeof(VIndex), block);
+        }
+      }
+    }, T(1));
+
+    uint64_t hash = hashCombine(uint64_t(m_nv), uint64_t(m_nc));
+    for (uint64_t blockHash : blockHashes) {
+      hash = hashCombine(hash, blockHash);
+    }
+    return hash;
+  }
+
+ private:
+  boost::filesystem::path derivedDataCachePath(
+      const boost::filesystem::path& meshPath, uint64_t hash) const {
+    if (m_derivedDataCacheDirectory.empty()) {
+      boost::filesystem::path cachePath = meshPath;
+      return cachePath += ".vtscache";
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.vtscache", (unsigned long long)hash);
+    return m_derivedDataCacheDirectory / name;
+  }
+
+  static uint64_t alignCacheOffset(uint64_t offset) {
+    return (offset + 15) & ~uint64_t(15);
+  }
+
+  // Fills the O table, normals and bounding box from a sidecar. Returns false,
+  // leaving the mesh untouched, if there is no usable sidecar for this hash.
+  bool loadDerivedDataCache(const boost::filesystem::path& cachePath,
+                            uint64_t hash) {
+    boost::system::error_code error;
+    uint64_t fileSize = boost::filesystem::file_size(cachePath, error);
+    if (error || fileSize < sizeof(DerivedDataCacheHeader)) {
+      return false;
+    }
+
+    boost::iostreams::mapped_file_source file;
+    try {
+      file.open(cachePath);
+    } catch (const std::exception&) {
+      return false;
+    }
+
+    DerivedDataCacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, "VTSCACHE", 8) != 0 ||
+        header.version != c_derivedDataCacheVersion ||
+        header.indexSize != sizeof(T) || header.scalarSize != sizeof(U) ||
+        header.contentHash != hash || header.nv != uint64_t(m_nv) ||
+        header.nc != uint64_t(m_nc) ||
+        header.oTableOffset + m_nc * sizeof(T) > fileSize ||
+        (header.normalsOffset != 0 &&
+         header.normalsOffset + 3 * m_nv * sizeof(U) > fileSize)) {
+      LOG("Stale derived data cache " << cachePath, DEBUG_LEVELS::VERBOSE);
+      return false;
+    }
+
+    const T* pOpposites =
+        reinterpret_cast<const T*>(file.data() + header.oTableOffset);
+    const U* pNormals =
+        reinterpret_cast<const U*>(file.data() + header.normalsOffset);
+    const bool fNormals = header.normalsOffset != 0;
+    const T numNormals = fNormals ? T(m_nv) : T(0);
+    m_OTable.resize(m_nc);
+    m_normals.resize(numNormals);
+    parallelFor<T>(0, std::max<T>(m_nc, numNormals), [&](T begin, T end) {
+      for (T i = begin; i < std::min<T>(end, m_nc); ++i) {
+        m_OTable[i] = CIndex(pOpposites[i]);
+      }
+      for (T i = begin; i < std::min<T>(end, numNormals); ++i) {
+        m_normals[i] = Vector<U>(pNormals[3 * i], pNormals[3 * i + 1],
+                                 pNormals[3 * i + 2]);
+      }
+    });
+
+    Point<U> low(header.boxLow[0], header.boxLow[1], header.boxLow[2]);
+    Point<U> high(header.boxHigh[0], header.boxHigh[1], header.boxHigh[2]);
+    setBoundingBox(low, high, false);
+    if (fNormals) {
+      m_validDerivedData |= DERIVED_NORMALS;
+    }
+    return true;
+  }
+
+  // Writes to a temporary file first, so a concurrent reader never maps a
+  // partly written sidecar. Failure to write only costs the next load time.
+  // Normals are written only if they are current, so that caching does not
+  // build them ahead of first use.
+  void saveDerivedDataCache(const boost::filesystem::path& cachePath,
+                            uint64_t hash) {
+    const bool fNormals = (m_validDerivedData & DERIVED_NORMALS) != 0;
+    ensureBoundingBox();
+
+    DerivedDataCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "VTSCACHE", 8);
+    header.version = c_derivedDataCacheVersion;
+    header.indexSize = sizeof(T);
+    header.scalarSize = sizeof(U);
+    header.contentHash = hash;
+    header.nv = m_nv;
+    header.nc = m_nc;
+    header.oTableOffset = alignCacheOffset(sizeof(header));
+    uint64_t normalsOffset =
+        alignCacheOffset(header.oTableOffset + m_nc * sizeof(T));
+    header.normalsOffset = fNormals ? normalsOffset : 0;
+    const Point<U>& low = m_boundingBox.low();
+    const Point<U>& high = m_boundingBox.high();
+    header.boxLow[0] = low.x();
+    header.boxLow[1] = low.y();
+    header.boxLow[2] = low.z();
+    header.boxHigh[0] = high.x();
+    header.boxHigh[1] = high.y();
+    header.boxHigh[2] = high.z();
+
+    std::vector<char> buffer(
+        fNormals ? normalsOffset + 3 * m_nv * sizeof(U) : normalsOffset, 0);
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    T* pOpposites = reinterpret_cast<T*>(buffer.data() + header.oTableOffset);
+    U* pNormals = reinterpret_cast<U*>(buffer.data() + normalsOffset);
+    for (T i = 0; i < m_nc; ++i) {
+      pOpposites[i] = m_OTable[i];
+    }
+    for (T i = 0; fNormals && i < m_nv; ++i) {
+      pNormals[3 * i] = m_normals[i].x();
+      pNormals[3 * i + 1] = m_normals[i].y();
+      pNormals[3 * i + 2] = m_normals[i].z();
+    }
+
+    boost::system::error_code error;
+    if (!m_derivedDataCacheDirectory.empty()) {
+      boost::filesystem::create_directories(m_derivedDataCacheDirectory, error);
+    }
+    boost::filesystem::path tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+      std::ofstream file(tempPath.string(),
+                         std::ios_base::out | std::ios_base::binary);
+      file.write(buffer.data(), buffer.size());
+      if (!file) {
+        LOG("Could not write derived data cache " << cachePath,
+            DEBUG_LEVELS::LOW);
+        return;
+      }
+    }
+    boost::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+      boost::filesystem::remove(tempPath, error);
+    }
+  }
+
+ public:
+
+  // Center the mesh at the origin and scale it uniformly so that its largest
+  // side is desiredBoundingBoxSize, given its current bounding box. Same as
+  // centerMesh followed by scaleMesh, as a single multiply-add per coordinate,
+  // with the resulting box derived from the input box instead of recomputed.
+  void normalizeGeometry(const Point<U>& low, const Point<U>& high,
+                         float desiredBoundingBoxSize) {
+    U boundingBoxSize = std::max<U>(
+        std::max<U>(high.x() - low.x(), high.y() - low.y()), high.z() - low.z());
+    U scale = boundingBoxSize > 0 ? desiredBoundingBoxSize / boundingBoxSize
+                                  : U(1);
+    Point<U> center(low, high);
+    const U offsetX = -scale * center.x();
+    const U offsetY = -scale * center.y();
+    const U offsetZ = -scale * center.z();
+
+    parallelFor<T>(0, m_nv, [this, scale, offsetX, offsetY, offsetZ](
+                                T begin, T end) {
+      for (T vIndex = begin; vIndex < end; ++vIndex) {
+        Point<U>& point = m_GTable[vIndex];
+        point.set(scale * point.x() + offsetX, scale * point.y() + offsetY,
+                  scale * point.z() + offsetZ);
+      }
+    });
+
+    Point<U> newLow(scale * low.x() + offsetX, scale * low.y() + offsetY,
+                    scale * low.z() + offsetZ);
+    Point<U> newHigh(scale * high.x() + offsetX, scale * high.y() + offsetY,
+                     scale * high.z() + offsetZ);
+    setBoundingBox(newLow, newHigh, false);
+    invalidateDerivedData(DERIVED_NORMALS);
+  }
+
   void saveMeshVTS(const std::string& fileName) {
     std::fstream file;
     file.open(fileName, std::ios_base::out | std::ios_base::binary);
@@ -824,13 +1434,50 @@ class Mesh : public IInteractableMesh {
                   });
   }
 
+  // For consumers outside the corner table such as the LOD cache
+  void exportFlatGeometry(std::vector<float>& positions,
+                          std::vector<unsigned int>& indices,
+                          std::vector<uint8_t>& triangleColors) override {
+    ensureMarkers();
+    positions.resize(3 * m_nv);
+    indices.resize(m_nc);
+    triangleColors.resize(4 * m_nt);
+    for (T vIndex = 0; vIndex < m_nv; ++vIndex) {
+      const Point<U>& point = m_GTable[vIndex];
+      positions[3 * vIndex] = point.x();
+      positions[3 * vIndex + 1] = point.y();
+      positions[3 * vIndex + 2] = point.z();
+    }
+    for (T cIndex = 0; cIndex < m_nc; ++cIndex) {
+      indices[cIndex] = m_VTable[cIndex];
+    }
+    for (T tIndex = 0; tIndex < m_nt; ++tIndex) {
+      triangleColor(TIndex(tIndex), &triangleColors[4 * tIndex]);
+    }
+  }
+
+  // Codes 0 to 2^numBits - 1 per axis of the bounding box, quantized one axis
+  // at a time with the batch kernels
   void quantizeGeometry(int numBits,
                         std::vector<Point<int>>& quantizedGeometry) {
-    std::for_each(m_GTable.begin(), m_GTable.end(),
-                  [&quantizedGeometry, this, &numBits](const Point<U>& point) {
-                    quantizedGeometry.push_back(point.quantizePoint<int>(
-                        m_boundingBox.low(), m_boundingBox.high(), numBits));
-                  });
+    ensureBoundingBox();
+    size_t count = m_GTable.size();
+    std::vector<U> coordinates(count);
+    std::vector<int> codes(3 * count);
+    for (int axis = 0; axis < 3; ++axis) {
+      for (size_t i = 0; i < count; ++i) {
+        coordinates[i] = m_GTable[i].get(axis);
+      }
+      quantizeValues(coordinates.data(), count,
+                     m_boundingBox.low().get(axis),
+                     m_boundingBox.high().get(axis), numBits,
+                     codes.data() + axis * count);
+    }
+    quantizedGeometry.reserve(quantizedGeometry.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+      quantizedGeometry.push_back(
+          Point<int>(codes[i], codes[count + i], codes[2 * count + i]));
+    }
   }
 
  protected:
@@ -880,6 +1527,7 @@ class Mesh : public IInteractableMesh {
   }
 
   void deserializeVTS(const std::string& fileName) {
+    invalidateDerivedData(DERIVED_ALL);
     std::fstream file;
     file.open(fileName, std::ios_base::in | std::ios_base::binary);
 
@@ -899,7 +1547,6 @@ class Mesh : public IInteractableMesh {
                     file >> m_VTable[cIndex] >> m_OTable[cIndex];
                   });
 
-    computeBox();
     populateAuxMembers();
   }
 #pragma endregion LOADING AND SAVING
@@ -922,9 +1569,11 @@ class Mesh : public IInteractableMesh {
   }
 
   void draw() override {
+    ensureColorMap();
     glColor3f(0.0, 1.0, 0.0);
 
     if (m_fDrawPlane) {
+      ensureBoundingBox();
       glBegin(GL_TRIANGLES);
       glVertex3f(m_boundingBox.low().x() - 10000,
                  m_boundingBox.low().y() - 10000, m_boundingBox.low().z());
@@ -942,6 +1591,18 @@ class Mesh : public IInteractableMesh {
       glEnd();
     }
 
+    // Packed positions are dequantized by the modelview matrix
+    glPushMatrix();
+    if (m_uploadedPrecision == AttributePrecision::PACKED) {
+      const PositionDequantization<U>& dequantization =
+          m_positionDequantization;
+      glTranslatef(dequantization.offset[0], dequantization.offset[1],
+                   dequantization.offset[2]);
+      glScalef(dequantization.scale, dequantization.scale,
+               dequantization.scale);
+      glEnable(GL_RESCALE_NORMAL);
+    }
+
     // First draw back triangles unshaded
     glEnable(GL_CULL_FACE);
     glCullFace(GL_FRONT);
@@ -952,16 +1613,13 @@ class Mesh : public IInteractableMesh {
     glEnableClientState(GL_COLOR_ARRAY);
     glEnable(GL_COLOR_MATERIAL);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
-    glVertexPointer(3, GL_FLOAT, 0, 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
-    glNormalPointer(GL_FLOAT, 0, 0);
+    bindVertexPointer();
+    bindNormalPointer();
 
     glBindBuffer(GL_ARRAY_BUFFER, m_colorVBO);
     glColorPointer(4, GL_UNSIGNED_BYTE, 0, 0);
 
-    glDrawArrays(GL_TRIANGLES, 0, 3 * m_nc);
+    glDrawArrays(GL_TRIANGLES, 0, m_nc);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDisableClientState(GL_VERTEX_ARRAY);
@@ -979,16 +1637,13 @@ class Mesh : public IInteractableMesh {
     glEnableClientState(GL_COLOR_ARRAY);
     glEnable(GL_COLOR_MATERIAL);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
-    glVertexPointer(3, GL_FLOAT, 0, 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
-    glNormalPointer(GL_FLOAT, 0, 0);
+    bindVertexPointer();
+    bindNormalPointer();
 
     glBindBuffer(GL_ARRAY_BUFFER, m_colorVBO);
     glColorPointer(4, GL_UNSIGNED_BYTE, 0, 0);
 
-    glDrawArrays(GL_TRIANGLES, 0, 3 * m_nc);
+    glDrawArrays(GL_TRIANGLES, 0, m_nc);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glDisableClientState(GL_VERTEX_ARRAY);
@@ -1001,13 +1656,27 @@ class Mesh : public IInteractableMesh {
     if (m_fShowEdges) {
       glColor3f(0, 0, 0);
       glEnableClientState(GL_VERTEX_ARRAY);
-      glBindBuffer(GL_ARRAY_BUFFER, m_edgeVBO);
-      glVertexPointer(3, GL_FLOAT, 0, 0);
-      glDrawArrays(GL_LINES, 0, 6 * m_nc);
+      bindVertexPointer();
+      if (m_fStreamedGeometry) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pStagingRing->bufferName());
+        glDrawElements(GL_LINES, m_numEdgeIndices, GL_UNSIGNED_INT,
+                       reinterpret_cast<const GLvoid*>(m_streamedEdgeOffset));
+      } else {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeIBO);
+        glDrawElements(GL_LINES, m_numEdgeIndices, GL_UNSIGNED_INT, 0);
+      }
+      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
       glBindBuffer(GL_ARRAY_BUFFER, 0);
       glDisableClientState(GL_VERTEX_ARRAY);
     }
 
+    glDisable(GL_RESCALE_NORMAL);
+    glPopMatrix();
+
+    if (m_fStreamedGeometry) {
+      m_pStagingRing->fenceCurrentRegion();
+    }
+
     if (m_fShowCorners) {
       std::for_each(cBeginCornerIterator(), cEndCornerIterator(),
                     [this](const CIndex& cIndex) {
@@ -1052,20 +1721,58 @@ class Mesh : public IInteractableMesh {
     }
   }
 
+  void bindVertexPointer() const {
+    const GLvoid* pOffset = 0;
+    if (m_fStreamedGeometry) {
+      glBindBuffer(GL_ARRAY_BUFFER, m_pStagingRing->bufferName());
+      pOffset = reinterpret_cast<const GLvoid*>(m_streamedVertexOffset);
+    } else {
+      glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
+    }
+    if (m_uploadedPrecision == AttributePrecision::PACKED) {
+      glVertexPointer(3, GL_SHORT, 4 * sizeof(int16_t), pOffset);
+    } else {
+      glVertexPointer(3, GL_FLOAT, 0, pOffset);
+    }
+  }
+
+  void bindNormalPointer() const {
+    const GLvoid* pOffset = 0;
+    if (m_fStreamedGeometry) {
+      glBindBuffer(GL_ARRAY_BUFFER, m_pStagingRing->bufferName());
+      pOffset = reinterpret_cast<const GLvoid*>(m_streamedNormalOffset);
+    } else {
+      glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
+    }
+    glNormalPointer(m_uploadedPrecision == AttributePrecision::PACKED
+                        ? GL_INT_2_10_10_10_REV
+                        : GL_FLOAT,
+                    0, pOffset);
+  }
+
+  // PACKED halves the per corner position and normal data; takes effect on
+  // the next updateGeometryVBO, and draw keeps binding the buffers in the
+  // uploaded layout until then
+  void setAttributePrecision(AttributePrecision precision) throw() {
+    m_attributePrecision = precision;
+  }
+
+  // RGBA colour of the marker of tIndex. Markers must be materialized
+  void triangleColor(TIndex tIndex, uint8_t* pColor) const {
+    uint32_t value = (unsigned int)(*(m_pColorMap))[m_tm[tIndex]];
+    pColor[0] = (value >> 24) & 0xFF;
+    pColor[1] = (value >> 16) & 0xFF;
+    pColor[2] = (value >> 8) & 0xFF;
+    pColor[3] = (value >> 0) & 0xFF;
+  }
+
   void updateColorsVBO() {
+    ensureMarkers();
+    touch();
     std::vector<uint8_t> col(4 * m_nc);
     std::for_each(beginCornerIterator(), endCornerIterator(),
                   [this, &col](const CIndex& cIndex) {
-                    uint32_t value =
-                        (unsigned int)(*(m_pColorMap))[m_tm[t(cIndex)]];
-                    uint8_t lolo = (value >> 0) & 0xFF;
-                    uint8_t lohi = (value >> 8) & 0xFF;
-                    uint8_t hilo = (value >> 16) & 0xFF;
-                    uint8_t hihi = (value >> 24) & 0xFF;
-                    col[4 * cIndex] = hihi;
-                    col[4 * cIndex + 1] = hilo;
-                    col[4 * cIndex + 2] = lohi;
-                    col[4 * cIndex + 3] = lolo;
+                    triangleColor(t(cIndex), &col[4 * cIndex]);
                   });
 
     glBindBuffer(GL_ARRAY_BUFFER, m_colorVBO);
@@ -1075,64 +1782,179 @@ class Mesh : public IInteractableMesh {
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
+  // Static meshes (typeMesh 0) are uploaded into their own VBOs. Dynamic ones
+  // (typeMesh 1), e.g. deforming mesh playback, are written straight into the
+  // next region of the staging ring when persistent mapping is available, so
+  // updates neither reallocate GPU storage nor wait for the GPU.
   void updateGeometryVBO(int typeMesh = 0)  // 0 static, 1 dynamic
   {
-    std::vector<U> geometry;
-    std::vector<U> normals;
-    std::for_each(beginCornerIterator(), endCornerIterator(),
-                  [this, &geometry](const CIndex& corner) {
-                    const Point<U>& currentPoint = g(corner);
-                    geometry.push_back(currentPoint.x());
-                    geometry.push_back(currentPoint.y());
-                    geometry.push_back(currentPoint.z());
-                  });
-
-    std::for_each(beginCornerIterator(), endCornerIterator(),
-                  [this, &normals](const CIndex& corner) {
-                    const Vector<U>& currentNormal = vNormal(corner);
-                    normals.push_back(currentNormal.x());
-                    normals.push_back(currentNormal.y());
-                    normals.push_back(currentNormal.z());
-                  });
+    ensureNormals();
+    std::vector<unsigned int> edgeIndices;
+    computeEdgeIndices(edgeIndices, m_featureEdgeAngle);
+    m_numEdgeIndices = GLsizei(edgeIndices.size());
+
+    bool fPacked = m_attributePrecision == AttributePrecision::PACKED;
+    m_uploadedPrecision = m_attributePrecision;
+    if (fPacked) {
+      ensureBoundingBox();
+      const Point<U>& boxLow = m_boundingBox.low();
+      const Point<U>& boxHigh = m_boundingBox.high();
+      U low[3] = {boxLow.x(), boxLow.y(), boxLow.z()};
+      U high[3] = {boxHigh.x(), boxHigh.y(), boxHigh.z()};
+      m_positionDequantization = positionDequantization16(low, high);
+    }
+    size_t vertexBytes =
+        size_t(m_nc) * (fPacked ? 4 * sizeof(int16_t) : 3 * sizeof(U));
+    size_t normalBytes =
+        size_t(m_nc) * (fPacked ? sizeof(uint32_t) : 3 * sizeof(U));
+    size_t edgeBytes = sizeof(unsigned int) * edgeIndices.size();
+
+    if (typeMesh == 1 && !m_fStagingRingFailed &&
+        GlStagingBackend::isSupported()) {
+      if (!m_pStagingRing) {
+        m_pStagingRing.reset(new StagingRing(
+            std::unique_ptr<IStagingBackend>(new GlStagingBackend())));
+      }
+      if (!m_pStagingRing->beginFrame(alignToStagingRing(vertexBytes) +
+                                      alignToStagingRing(normalBytes) +
+                                      alignToStagingRing(edgeBytes))) {
+        uploadGeometryToVBOs(typeMesh, vertexBytes, normalBytes, edgeIndices);
+        m_pStagingRing.reset();
+        m_fStagingRingFailed = true;
+        LOG("Could not map the staging ring; dynamic geometry goes to VBOs",
+            DEBUG_LEVELS::LOW);
+        return;
+      }
+      StagingRing::Allocation vertices = m_pStagingRing->allocate(vertexBytes);
+      StagingRing::Allocation normals = m_pStagingRing->allocate(normalBytes);
+      StagingRing::Allocation edges = m_pStagingRing->allocate(edgeBytes);
+      writeCornerAttributes(vertices.pData, normals.pData);
+      std::copy(edgeIndices.begin(), edgeIndices.end(),
+                reinterpret_cast<unsigned int*>(edges.pData));
+      m_streamedVertexOffset = vertices.offset;
+      m_streamedNormalOffset = normals.offset;
+      m_streamedEdgeOffset = edges.offset;
+      m_fStreamedGeometry = true;
+      return;
+    }
+    uploadGeometryToVBOs(typeMesh, vertexBytes, normalBytes, edgeIndices);
+  }
 
-    std::vector<U> edgeGeometry;
-    std::for_each(beginCornerIterator(), endCornerIterator(),
-                  [this, &edgeGeometry](const CIndex& corner) {
-                    const Point<U>& currentPoint = g(corner);
-                    edgeGeometry.push_back(currentPoint.x());
-                    edgeGeometry.push_back(currentPoint.y());
-                    edgeGeometry.push_back(currentPoint.z());
-
-                    CIndex offsetForNext = CIndex(1);
-                    if ((corner + 1) % 3 == CIndex(0)) {
-                      offsetForNext = CIndex(-2);
-                    }
-                    const Point<U>& nextPoint =
-                        g(CIndex(corner + offsetForNext));
-                    edgeGeometry.push_back(nextPoint.x());
-                    edgeGeometry.push_back(nextPoint.y());
-                    edgeGeometry.push_back(nextPoint.z());
-                  });
+  void uploadGeometryToVBOs(int typeMesh, size_t vertexBytes,
+                            size_t normalBytes,
+                            const std::vector<unsigned int>& edgeIndices) {
+    m_fStreamedGeometry = false;
+    std::vector<unsigned char> vertices(vertexBytes);
+    std::vector<unsigned char> normals(normalBytes);
+    writeCornerAttributes(vertices.data(), normals.data());
 
+    GLenum usage = typeMesh == 0 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
     glBindBuffer(GL_ARRAY_BUFFER, m_vertexVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(U) * geometry.size(), geometry.data(),
-                 typeMesh == 0 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertices.data(), usage);
 
     glBindBuffer(GL_ARRAY_BUFFER, m_normalVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(U) * normals.size(), normals.data(),
-                 typeMesh == 0 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, normalBytes, normals.data(), usage);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_edgeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(U) * edgeGeometry.size(),
-                 edgeGeometry.data(),
-                 typeMesh == 0 ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_edgeIBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, edgeBytes, edgeIndices.data(), usage);
 
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
   }
 
+  // Per corner positions and normals in the layout being uploaded. Written
+  // front to back in blocks, which suits write-combined mapped memory
+  void writeCornerAttributes(unsigned char* pVertices,
+                             unsigned char* pNormals) const {
+    bool fPacked = m_uploadedPrecision == AttributePrecision::PACKED;
+    parallelFor<T>(0, m_nc, [&](T begin, T end) {
+      std::vector<U> geometry(3 * size_t(end - begin));
+      std::vector<U> normals(3 * size_t(end - begin));
+      for (T corner = begin; corner < end; ++corner) {
+        const Point<U>& point = g(CIndex(corner));
+        const Vector<U>& normal = m_normals[v(CIndex(corner))];
+        size_t i = 3 * size_t(corner - begin);
+        geometry[i] = point.x();
+        geometry[i + 1] = point.y();
+        geometry[i + 2] = point.z();
+        normals[i] = normal.x();
+        normals[i + 1] = normal.y();
+        normals[i + 2] = normal.z();
+      }
+      if (fPacked) {
+        quantizePositions16(geometry.data(), end - begin,
+                            m_positionDequantization,
+                            reinterpret_cast<int16_t*>(pVertices) + 4 * begin);
+        packNormals2101010(normals.data(), end - begin,
+                           reinterpret_cast<uint32_t*>(pNormals) + begin);
+      } else {
+        std::copy(geometry.begin(), geometry.end(),
+                  reinterpret_cast<U*>(pVertices) + 3 * begin);
+        std::copy(normals.begin(), normals.end(),
+                  reinterpret_cast<U*>(pNormals) + 3 * begin);
+      }
+    });
+  }
+
+  // Only draw edges whose dihedral angle exceeds angle (radians), plus
+  // boundary edges. Takes effect on the next updateGeometryVBO
+  void setFeatureEdgeAngle(U angle) throw() { m_featureEdgeAngle = angle; }
+
+  // Line list of every edge once, as pairs of corner indices (the layout of
+  // m_vertexVBO). An interior edge is emitted from the side where c < o(c),
+  // a boundary edge from its only side. With a positive featureAngle only
+  // boundary edges and edges whose triangles meet at a dihedral angle above
+  // it are kept.
+  void computeEdgeIndices(std::vector<unsigned int>& edgeIndices,
+                          U featureAngle = 0) const {
+    const T c_blockSize = 1 << 16;
+    T numBlocks = (m_nc + c_blockSize - 1) / c_blockSize;
+    U minCosine = std::cos(featureAngle);
+    auto fKeep = [this, featureAngle, minCosine](CIndex corner) {
+      CIndex opposite = o(corner);
+      if (opposite == -1) {
+        return true;
+      }
+      if (corner > opposite) {
+        return false;
+      }
+      return featureAngle <= 0 ||
+             triangleNormal(corner, true).dot(triangleNormal(opposite, true)) <
+                 minCosine;
+    };
+
+    // Count per block, then fill each block at its prefix offset
+    std::vector<T> blockOffsets(numBlocks + 1, 0);
+    parallelFor<T>(0, numBlocks, [&](T begin, T end) {
+      for (T block = begin; block < end; ++block) {
+        T cEnd = std::min<T>((block + 1) * c_blockSize, m_nc);
+        for (T cIndex = block * c_blockSize; cIndex < cEnd; ++cIndex) {
+          blockOffsets[block + 1] += fKeep(CIndex(cIndex));
+        }
+      }
+    }, T(1));
+    for (T block = 0; block < numBlocks; ++block) {
+      blockOffsets[block + 1] += blockOffsets[block];
+    }
+
+    edgeIndices.resize(2 * size_t(blockOffsets[numBlocks]));
+    parallelFor<T>(0, numBlocks, [&](T begin, T end) {
+      for (T block = begin; block < end; ++block) {
+        size_t next = 2 * size_t(blockOffsets[block]);
+        T cEnd = std::min<T>((block + 1) * c_blockSize, m_nc);
+        for (T cIndex = block * c_blockSize; cIndex < cEnd; ++cIndex) {
+          if (fKeep(CIndex(cIndex))) {
+            edgeIndices[next++] = n(CIndex(cIndex));
+            edgeIndices[next++] = p(CIndex(cIndex));
+          }
+        }
+      }
+    }, T(1));
+  }
+
   void initVBO(int typeMesh) {
     glGenBuffers(1, &m_vertexVBO);
-    glGenBuffers(1, &m_edgeVBO);
+    glGenBuffers(1, &m_edgeIBO);
     glGenBuffers(1, &m_colorVBO);
     glGenBuffers(1, &m_normalVBO);
 
@@ -1293,15 +2115,66 @@ class Mesh : public IInteractableMesh {
     setOpposites(l2, r2);
   }
 
+ public:
+  // Build the mesh in one go from flat x y z positions and three vertex
+  // indices per triangle, replacing any current contents. Every table is
+  // sized once, and the O table and normals are built in parallel from one
+  // shared vertex to corner incidence.
+  void buildFromArrays(const U* positions, T numVertices, const T* indices,
+                       T numTriangles) {
+    std::vector<Point<U>> geometry(numVertices);
+    std::vector<VIndex> vTable(3 * numTriangles);
+    parallelFor<T>(0, numVertices, [&](T begin, T end) {
+      for (T vIndex = begin; vIndex < end; ++vIndex) {
+        geometry[vIndex] =
+            Point<U>(positions[3 * vIndex], positions[3 * vIndex + 1],
+                     positions[3 * vIndex + 2]);
+      }
+    });
+    parallelFor<T>(0, 3 * numTriangles, [&](T begin, T end) {
+      for (T cIndex = begin; cIndex < end; ++cIndex) {
+        vTable[cIndex] = VIndex(indices[cIndex]);
+      }
+    });
+    buildFromTables(std::move(geometry), std::move(vTable));
+  }
+
+  // Same as buildFromArrays, adopting the caller's G and V tables without a
+  // copy
+  void buildFromTables(std::vector<Point<U>>&& geometry,
+                       std::vector<VIndex>&& vTable) {
+    assert(vTable.size() % 3 == 0);
+    invalidateDerivedData(DERIVED_ALL);
+    m_GTable = std::move(geometry);
+    m_VTable = std::move(vTable);
+    m_nv = VIndex(T(m_GTable.size()));
+    m_nc = CIndex(T(m_VTable.size()));
+    m_nt = TIndex(m_nc / 3);
+
+    std::vector<T> firstIncidentCorner;
+    std::vector<CIndex> incidentCorners;
+    computeIncidentCorners(firstIncidentCorner, incidentCorners);
+    computeOFromIncidentCorners(firstIncidentCorner, incidentCorners);
+    populateNormalsFromIncidentCorners(firstIncidentCorner, incidentCorners);
+    populateAuxMembers();
+  }
+
+ private:
   void addVertex(const Point<U>& p) {
+    updateBoundingBox(nullptr, &p);
     m_GTable.emplace_back(p);
-    m_vm.push_back(0);
-    m_fVRemoved.push_back(false);
+    if (m_validDerivedData & DERIVED_MARKERS) {
+      m_vm.push_back(0);
+      m_fVRemoved.push_back(false);
+    }
     m_nv++;
+    invalidateDerivedData(DERIVED_NORMALS);
   }
 
   void replaceVertex(VIndex vIndex, const Point<U>& newVertex) {
+    updateBoundingBox(&m_GTable[vIndex], &newVertex);
     m_GTable[vIndex] = newVertex;
+    invalidateDerivedData(DERIVED_NORMALS);
   }
 
   void addTriangle(VIndex v1, VIndex v2, VIndex v3) {
@@ -1309,14 +2182,95 @@ class Mesh : public IInteractableMesh {
     m_VTable.push_back(v2);
     m_VTable.push_back(v3);
     m_OTable.resize(m_OTable.size() + 3);
-    m_tm.push_back(0);
+    if (m_validDerivedData & DERIVED_MARKERS) {
+      m_tm.push_back(0);
+    }
     m_nt++;
     m_nc += 3;
+    invalidateDerivedData(DERIVED_NORMALS);
+
+    if (m_pOpenEdges) {
+      for (CIndex cIndex = CIndex(m_nc - 3); cIndex < m_nc; ++cIndex) {
+        linkOpenEdge(cIndex);
+      }
+    }
+  }
+
+ public:
+  // While a construction session is open, addTriangle and removeTriangle keep
+  // the O table current: edges without an opposite are kept in a hash map
+  // keyed by their directed vertex pair, so a new triangle finds the
+  // opposites of its edges in constant time. The O table must be valid when
+  // the session begins, e.g. empty or after computeO.
+  void beginConstructionSession() {
+    m_pOpenEdges.reset(new std::unordered_map<uint64_t, CIndex>());
+    for (T cIndex = 0; cIndex < m_nc; ++cIndex) {
+      if (o(CIndex(cIndex)) == -1) {
+        m_pOpenEdges->emplace(openEdgeKey(CIndex(cIndex)), CIndex(cIndex));
+      }
+    }
+  }
+
+  void endConstructionSession() { m_pOpenEdges.reset(); }
+
+  bool isConstructionSessionOpen() const throw() {
+    return m_pOpenEdges != nullptr;
+  }
+
+ private:
+  // Key of the directed edge opposite cIndex, from v(n(c)) to v(p(c))
+  uint64_t openEdgeKey(CIndex cIndex) const {
+    return edgeKey(v(n(cIndex)), v(p(cIndex)));
+  }
+
+  static uint64_t edgeKey(VIndex from, VIndex to) {
+    return (uint64_t(uint32_t(from)) << 32) | uint32_t(to);
+  }
+
+  // Match the edge opposite cIndex with the reverse edge of an earlier
+  // triangle, or record it as open
+  void linkOpenEdge(CIndex cIndex) {
+    auto match = m_pOpenEdges->find(edgeKey(v(p(cIndex)), v(n(cIndex))));
+    if (match != m_pOpenEdges->end()) {
+      setOpposites(cIndex, match->second);
+      m_pOpenEdges->erase(match);
+    } else {
+      setOTable(cIndex, CIndex(-1));
+      // A second open edge with the same direction is non-manifold or
+      // misoriented; it stays a boundary edge
+      m_pOpenEdges->emplace(openEdgeKey(cIndex), cIndex);
+    }
+  }
+
+  void moveOpenEdge(CIndex from, CIndex to) {
+    auto entry = m_pOpenEdges->find(openEdgeKey(from));
+    if (entry != m_pOpenEdges->end() && entry->second == from) {
+      entry->second = to;
+    }
+  }
+
+  // Called by removeTriangle for each corner of the removed triangle
+  void unlinkOpenEdge(CIndex cIndex) {
+    CIndex opposite = o(cIndex);
+    if (opposite == -1) {
+      auto entry = m_pOpenEdges->find(openEdgeKey(cIndex));
+      if (entry != m_pOpenEdges->end() && entry->second == cIndex) {
+        m_pOpenEdges->erase(entry);
+      }
+    } else if (o(opposite) == cIndex) {
+      setOTable(opposite, CIndex(-1));
+      m_pOpenEdges->emplace(openEdgeKey(opposite), opposite);
+    }
   }
 
   void removeTriangle(CIndex corner) {
     TIndex toTIndex = t(corner);
     TIndex fromTIndex = TIndex(nt() - 1);
+    if (m_pOpenEdges) {
+      for (CIndex cIndex = c(toTIndex); cIndex < c(toTIndex) + 3; ++cIndex) {
+        unlinkOpenEdge(cIndex);
+      }
+    }
     if (toTIndex != fromTIndex) {
       CIndex initToCIndex = c(toTIndex);
       CIndex initFromCIndex = c(fromTIndex);
@@ -1324,22 +2278,35 @@ class Mesh : public IInteractableMesh {
       std::for_each(beginNextIterator(initToCIndex),
                     endNextIterator(initToCIndex),
                     [this, &fromCIndexIterator](const CIndex& toCIndex) {
-                      setOpposites(toCIndex, o(*fromCIndexIterator));
+                      CIndex opposite = o(*fromCIndexIterator);
+                      if (opposite == -1) {
+                        // Boundary edge; there is no opposite to point back
+                        setOTable(toCIndex, CIndex(-1));
+                        if (m_pOpenEdges) {
+                          moveOpenEdge(*fromCIndexIterator, toCIndex);
+                        }
+                      } else {
+                        setOpposites(toCIndex, opposite);
+                      }
                       setVTable(toCIndex, v(*fromCIndexIterator));
                       fromCIndexIterator++;
                     });
 
-      m_tm[toTIndex] = m_tm[fromTIndex];
+      if (m_validDerivedData & DERIVED_MARKERS) {
+        m_tm[toTIndex] = m_tm[fromTIndex];
+      }
 
       notifyTIndexChange(fromTIndex, toTIndex);
     }
 
     m_nt--;
     m_nc -= 3;
+    invalidateDerivedData(DERIVED_NORMALS);
   }
 
   void removeVertex(VIndex fromVIndex) {
     VIndex toVIndex = VIndex(-1);
+    ensureMarkers();
     m_fVRemoved[fromVIndex] = true;
     notifyVIndexChange(fromVIndex, toVIndex);
   }
@@ -1350,6 +2317,7 @@ class Mesh : public IInteractableMesh {
   }
 
   void compressVTable() {
+    ensureMarkers();
     assert(m_fVRemoved.size() == (int)nv());
     VIndex newIndex = VIndex(0);
     std::vector<VIndex> vToCompressedVMap;
@@ -1375,6 +2343,7 @@ class Mesh : public IInteractableMesh {
 
     m_nv = newIndex;
     m_fVRemoved.assign(m_nv, false);
+    invalidateDerivedData(DERIVED_NORMALS | DERIVED_BOUNDING_BOX);
   }
 
  public:
@@ -1389,11 +2358,13 @@ class Mesh : public IInteractableMesh {
                   });
 #endif
 
-    m_tm.resize(m_nt);
+    if (m_validDerivedData & DERIVED_MARKERS) {
+      m_tm.resize(m_nt);
+      m_vm.resize(m_nv);
+    }
     m_OTable.resize(m_nc);
     m_VTable.resize(m_nc);
     m_GTable.resize(m_nv);
-    m_vm.resize(m_nv);
 
     m_tm.shrink_to_fit();
     m_OTable.shrink_to_fit();
@@ -1443,22 +2414,118 @@ class Mesh : public IInteractableMesh {
   // from s(corner1) to corner2 are incident on geom2. The rest on geom1
   VIndex expandVertex(CIndex corner1, CIndex corner2, const Point<U>& geom1,
                       const Point<U>& geom2, bool fAddTriangles) {
+    VIndex newVertex =
+        splitVertex(corner1, corner2, geom1, geom2, fAddTriangles);
+    appendMarkers();
+    if (m_validDerivedData & DERIVED_NORMALS) {
+      updateNormalsAround(corner1);
+      updateNormalsAround(corner2);
+    }
+    return newVertex;
+  }
+
+  // Arguments of one expandVertex call
+  struct VertexSplit {
+    CIndex corner1;
+    CIndex corner2;
+    Point<U> geom1;
+    Point<U> geom2;
+    bool fAddTriangles;
+  };
+
+  // Arguments of one triangleExpandOperation call
+  struct TriangleExpansion {
+    std::array<CIndex, 3> corners;
+    std::array<Point<U>, 3> geometry;
+  };
+
+  // What a batch of splits changed. Added vertices and triangles are
+  // contiguous ranges at the end of their tables; no existing index moves.
+  struct VertexSplitReport {
+    VIndex firstAddedVertex;
+    T numAddedVertices;
+    TIndex firstAddedTriangle;
+    T numAddedTriangles;
+    std::vector<VIndex> movedVertices;  // Existing vertices given new geometry
+    double splitsPerSecond;
+  };
+
+  // Apply expandVertex for every split in order, as for refinement or
+  // progressive decoding. Capacity is reserved once, opposites are only set
+  // for the corners each split touches, and markers and derived data are
+  // brought up to date once at the end.
+  VertexSplitReport applyVertexSplits(const std::vector<VertexSplit>& splits) {
+    auto startTime = std::chrono::steady_clock::now();
+    VertexSplitReport report = beginSplits(splits.size());
+    std::vector<CIndex> touchedCorners;
+    touchedCorners.reserve(2 * splits.size());
+    for (const VertexSplit& split : splits) {
+      report.movedVertices.push_back(v(split.corner1));
+      splitVertex(split.corner1, split.corner2, split.geom1, split.geom2,
+                  split.fAddTriangles);
+      touchedCorners.push_back(split.corner1);
+      touchedCorners.push_back(split.corner2);
+    }
+    endSplits(report, splits.size(), touchedCorners, startTime);
+    return report;
+  }
+
+  // Batched triangleExpandOperation; each expansion is two vertex splits
+  VertexSplitReport applyTriangleExpansions(
+      const std::vector<TriangleExpansion>& expansions) {
+    auto startTime = std::chrono::steady_clock::now();
+    VertexSplitReport report = beginSplits(2 * expansions.size());
+    std::vector<CIndex> touchedCorners;
+    touchedCorners.reserve(4 * expansions.size());
+    for (const TriangleExpansion& expansion : expansions) {
+      const std::array<CIndex, 3>& corners = expansion.corners;
+      const std::array<Point<U>, 3>& geometry = expansion.geometry;
+      VIndex firstMoved = v(corners[1]);
+      splitVertex(corners[1], corners[2], geometry[1], geometry[2], true);
+      CIndex secondSplitCorner = s(corners[1]);
+      splitVertex(corners[0], secondSplitCorner, geometry[0], geometry[1],
+                  false);
+      touchedCorners.push_back(corners[0]);
+      touchedCorners.push_back(corners[1]);
+      touchedCorners.push_back(corners[2]);
+      touchedCorners.push_back(secondSplitCorner);
+      report.movedVertices.push_back(firstMoved);
+      if (v(corners[0]) != firstMoved) {
+        report.movedVertices.push_back(v(corners[0]));
+      }
+    }
+    endSplits(report, 2 * expansions.size(), touchedCorners, startTime);
+    return report;
+  }
+
+ private:
+  // Move revision() on. Every edit of the G, V or O tables calls this, whether
+  // or not it also invalidates derived data
+  void touch() throw() { m_revision++; }
+
+  // The table edits of expandVertex, without marker or derived data upkeep
+  VIndex splitVertex(CIndex corner1, CIndex corner2, const Point<U>& geom1,
+                     const Point<U>& geom2, bool fAddTriangles) {
     assert(v(corner1) == v(corner2));
-    replaceVertex(v(corner1), geom1);
-    addVertex(geom2);
+    touch();
+    updateBoundingBox(&m_GTable[v(corner1)], &geom1);
+    updateBoundingBox(nullptr, &geom2);
+    m_GTable[v(corner1)] = geom1;
+    m_GTable.push_back(geom2);
+    m_nv++;
 
     for (auto iter = beginSwingIterator(s(corner1));
          iter != endSwingIterator(s(corner2)); iter++) {
-      setVTable(*iter, VIndex(m_nv - 1));
+      m_VTable[*iter] = VIndex(m_nv - 1);
     }
 
     CIndex offsetCorner = m_nc;
-    addTriangle(v(corner1), v(p(corner1)), v(corner2));
+    appendTriangle(v(corner1), v(p(corner1)), v(corner2));
 
     if (fAddTriangles)
-      addTriangle(v(corner2), v(p(corner2)), v(corner1));
+      appendTriangle(v(corner2), v(p(corner2)), v(corner1));
     else
-      addTriangle(v(corner1), v(corner2), v(p(corner2)));
+      appendTriangle(v(corner1), v(corner2), v(p(corner2)));
 
     setOpposites(p(s(corner1)), CIndex(offsetCorner));
     setOpposites(n(corner1), CIndex(offsetCorner + 2));
@@ -1476,6 +2543,61 @@ class Mesh : public IInteractableMesh {
     return VIndex(m_nv - 1);
   }
 
+  void appendTriangle(VIndex v1, VIndex v2, VIndex v3) {
+    m_VTable.push_back(v1);
+    m_VTable.push_back(v2);
+    m_VTable.push_back(v3);
+    m_OTable.resize(m_OTable.size() + 3, CIndex(-1));
+    m_nt++;
+    m_nc += 3;
+    touch();
+  }
+
+  // Extend the markers, if materialized, to cover added vertices and triangles
+  void appendMarkers() {
+    if (m_validDerivedData & DERIVED_MARKERS) {
+      m_vm.resize(m_nv, 0);
+      m_fVRemoved.resize(m_nv, false);
+      m_tm.resize(m_nt, 0);
+    }
+  }
+
+  VertexSplitReport beginSplits(size_t numSplits) {
+    m_GTable.reserve(m_GTable.size() + numSplits);
+    m_VTable.reserve(m_VTable.size() + 6 * numSplits);
+    m_OTable.reserve(m_OTable.size() + 6 * numSplits);
+
+    VertexSplitReport report;
+    report.firstAddedVertex = m_nv;
+    report.firstAddedTriangle = m_nt;
+    report.movedVertices.reserve(numSplits);
+    return report;
+  }
+
+  void endSplits(VertexSplitReport& report, size_t numSplits,
+                 const std::vector<CIndex>& touchedCorners,
+                 std::chrono::steady_clock::time_point startTime) {
+    appendMarkers();
+    // Local normal updates touch each one-ring a few times over, so past a
+    // fraction of the mesh a full rebuild is cheaper
+    if (m_validDerivedData & DERIVED_NORMALS) {
+      if (touchedCorners.size() > size_t(m_nv / 4)) {
+        populateNormals();
+      } else {
+        for (CIndex corner : touchedCorners) {
+          updateNormalsAround(corner);
+        }
+      }
+    }
+    report.numAddedVertices = m_nv - report.firstAddedVertex;
+    report.numAddedTriangles = m_nt - report.firstAddedTriangle;
+
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - startTime).count();
+    report.splitsPerSecond = seconds > 0 ? numSplits / seconds : 0;
+  }
+
+ public:
   class LRTriangleIndexChangeHandler {
    private:
     TIndex m_lTriangle;
@@ -1528,12 +2650,21 @@ class Mesh : public IInteractableMesh {
   VIndex collapseEdge(CIndex corner, CIndex oppositeCorner,
                       const Point<U>& pointAfterCollapse) {
     assert(corner == o(oppositeCorner));
+    bool fUpdateNormals = (m_validDerivedData & DERIVED_NORMALS) != 0;
 
     CIndex cEdge1 = n(corner);
     CIndex cEdge2 = p(corner);
     VIndex vEdge1 = v(n(corner));
     VIndex vEdge2 = v(p(corner));
 
+    // A surviving triangle on vEdge1, followed through the triangle moves of
+    // removeTriangle, to find the fan of vEdge1 for the normal update
+    CIndex neighbourCorner = o(p(corner));
+    TIndex survivor = neighbourCorner == -1 ? TIndex(-1) : t(neighbourCorner);
+    if (survivor == t(corner) || survivor == t(oppositeCorner)) {
+      survivor = TIndex(-1);
+    }
+
     std::for_each(
         beginSwingIterator(cEdge2), endSwingIterator(cEdge2),
         [this, &vEdge1](const CIndex& cIndex) { setVTable(cIndex, vEdge1); });
@@ -1553,8 +2684,28 @@ class Mesh : public IInteractableMesh {
           [this](const CIndex& cIndex) { setOTable(cIndex, CIndex(-1)); });
     });
 
-    removeTriangle(oppositeCorner > corner ? oppositeCorner : corner);
-    removeTriangle(oppositeCorner < corner ? oppositeCorner : corner);
+    std::array<CIndex, 2> removeOrder = {std::max(corner, oppositeCorner),
+                                         std::min(corner, oppositeCorner)};
+    for (CIndex removeCorner : removeOrder) {
+      // removeTriangle moves the last triangle into the freed slot
+      if (survivor == TIndex(nt() - 1)) {
+        survivor = t(removeCorner);
+      }
+      removeTriangle(removeCorner);
+    }
+
+    if (fUpdateNormals) {
+      if (survivor == -1) {
+        populateNormals();  // No fan to start from; rare, on boundaries
+      } else {
+        m_validDerivedData |= DERIVED_NORMALS;
+        for (CIndex cIndex = c(survivor); cIndex < c(survivor) + 3; ++cIndex) {
+          if (v(cIndex) == vEdge1) {
+            updateNormalsAround(cIndex);
+          }
+        }
+      }
+    }
     return vEdge1;
   }
 
@@ -1641,15 +2792,18 @@ class Mesh : public IInteractableMesh {
 
 #pragma region STATSFINDING
  public:
+  // Prints valence and vertex count pairs. See computeMeshStatistics in
+  // meshStatistics.h for the full set of metrics as data
   void findValenceHistogram() {
     std::vector<int> valence;
     valence.assign(m_nv, 0);
     std::for_each(beginCornerIterator(), endCornerIterator(),
                   [this, &valence](CIndex cIndex) { valence[v(cIndex)]++; });
-    std::map<int, int> histogram = computeHistogram<int>(valence);
-    for (std::map<int, int>::iterator iter = histogram.begin();
-         iter != histogram.end(); iter++) {
-      std::cout << iter->first << " " << iter->second << "\n";
+    std::vector<int> histogram = computeDenseHistogram(valence);
+    for (size_t value = 0; value < histogram.size(); value++) {
+      if (histogram[value] != 0) {
+        std::cout << value << " " << histogram[value] << "\n";
+      }
     }
   }
 
@@ -1658,6 +2812,7 @@ class Mesh : public IInteractableMesh {
 #pragma region DEBUG
  public:
   void colorTriangles(const std::vector<TIndex>& triangleList, COLORS color) {
+    ensureMarkers();
     unsigned int colorIndex = m_pColorMap->getIndexForColor(color);
     std::for_each(
         triangleList.begin(), triangleList.end(),
@@ -1665,6 +2820,7 @@ class Mesh : public IInteractableMesh {
   }
 
   void colorVertices(const std::vector<VIndex>& vertexList, COLORS color) {
+    ensureMarkers();
     m_fShowVertices = true;
     if (m_vm.size() == 0) {
       unsigned int colorIndex = m_pColorMap->getIndexForColor(COLORS::NONE);
@@ -1677,6 +2833,7 @@ class Mesh : public IInteractableMesh {
   }
 
   void colorCorners(const std::vector<CIndex>& cornerList, COLORS color) {
+    ensureColorMap();
     m_fShowCorners = true;
     if (m_cm.size() == 0) {
       unsigned int colorIndex = m_pColorMap->getIndexForColor(COLORS::NONE);
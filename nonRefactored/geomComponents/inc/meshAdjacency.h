@@ -0,0 +1,109 @@
+#ifndef _MESH_ADJACENCY_H_
+#define _MESH_ADJACENCY_H_
+
+#include <vector>
+
+#include "mesh.h"
+
+// Flat (CSR) vertex adjacency derived once from the V and O tables of a mesh.
+// Algorithms that repeatedly visit one-rings (geodesics, smoothing) read these
+// arrays linearly instead of chasing swing iterators through the O table.
+template <class T, class U>
+class MeshAdjacency {
+ public:
+  typedef typename Mesh<T, U>::VIndex VIndex;
+  typedef typename Mesh<T, U>::CIndex CIndex;
+
+ private:
+  // Neighbouring vertices of v are m_neighbours[m_neighbourOffsets[v] ..
+  // m_neighbourOffsets[v + 1]), with the matching edge lengths alongside
+  std::vector<T> m_neighbourOffsets;
+  std::vector<T> m_neighbours;
+  std::vector<U> m_edgeLengths;
+
+  // Corners incident on v are m_corners[m_cornerOffsets[v] ..
+  // m_cornerOffsets[v + 1])
+  std::vector<T> m_cornerOffsets;
+  std::vector<T> m_corners;
+
+ public:
+  explicit MeshAdjacency(const Mesh<T, U>& mesh) { build(mesh); }
+
+  void build(const Mesh<T, U>& mesh) {
+    T nv = mesh.nv();
+    T nc = mesh.nc();
+
+    m_neighbourOffsets.assign(nv + 1, 0);
+    m_cornerOffsets.assign(nv + 1, 0);
+
+    // Each edge is visited once from the corner opposite to it: keep c when
+    // c < o(c), or when the edge is on the boundary (o(c) == -1)
+    for (T c = 0; c < nc; ++c) {
+      CIndex corner = CIndex(c);
+      m_cornerOffsets[mesh.v(corner) + 1]++;
+      if (isEdgeRepresentative(mesh, corner)) {
+        m_neighbourOffsets[mesh.v(mesh.n(corner)) + 1]++;
+        m_neighbourOffsets[mesh.v(mesh.p(corner)) + 1]++;
+      }
+    }
+    for (T i = 0; i < nv; ++i) {
+      m_neighbourOffsets[i + 1] += m_neighbourOffsets[i];
+      m_cornerOffsets[i + 1] += m_cornerOffsets[i];
+    }
+
+    m_neighbours.resize(m_neighbourOffsets[nv]);
+    m_edgeLengths.resize(m_neighbourOffsets[nv]);
+    m_corners.resize(m_cornerOffsets[nv]);
+
+    std::vector<T> neighbourFill(m_neighbourOffsets.begin(),
+                                 m_neighbourOffsets.end() - 1);
+    std::vector<T> cornerFill(m_cornerOffsets.begin(),
+                              m_cornerOffsets.end() - 1);
+    for (T c = 0; c < nc; ++c) {
+      CIndex corner = CIndex(c);
+      m_corners[cornerFill[mesh.v(corner)]++] = c;
+      if (isEdgeRepresentative(mesh, corner)) {
+        T a = mesh.v(mesh.n(corner));
+        T b = mesh.v(mesh.p(corner));
+        U length = mesh.geom(VIndex(a)).distance(mesh.geom(VIndex(b)));
+        m_neighbours[neighbourFill[a]] = b;
+        m_edgeLengths[neighbourFill[a]++] = length;
+        m_neighbours[neighbourFill[b]] = a;
+        m_edgeLengths[neighbourFill[b]++] = length;
+      }
+    }
+  }
+
+  static bool isEdgeRepresentative(const Mesh<T, U>& mesh, CIndex corner) {
+    CIndex opposite = mesh.o(corner);
+    return opposite == -1 || corner < opposite;
+  }
+
+  T numVertices() const throw() { return T(m_neighbourOffsets.size()) - 1; }
+
+  T neighbourBegin(T v) const throw() { return m_neighbourOffsets[v]; }
+  T neighbourEnd(T v) const throw() { return m_neighbourOffsets[v + 1]; }
+  T neighbour(T slot) const throw() { return m_neighbours[slot]; }
+  U edgeLength(T slot) const throw() { return m_edgeLengths[slot]; }
+
+  // Slot of neighbour in the list of v, or -1. Linear in the valence of v
+  T findNeighbourSlot(T v, T neighbour) const throw() {
+    for (T slot = neighbourBegin(v); slot < neighbourEnd(v); ++slot) {
+      if (m_neighbours[slot] == neighbour) {
+        return slot;
+      }
+    }
+    return T(-1);
+  }
+
+  T cornerBegin(T v) const throw() { return m_cornerOffsets[v]; }
+  T cornerEnd(T v) const throw() { return m_cornerOffsets[v + 1]; }
+  T corner(T slot) const throw() { return m_corners[slot]; }
+
+  const std::vector<T>& neighbourOffsets() const throw() {
+    return m_neighbourOffsets;
+  }
+  const std::vector<T>& neighbours() const throw() { return m_neighbours; }
+};
+
+#endif  //_MESH_ADJACENCY_H_
@@ -0,0 +1,202 @@
+#ifndef _MESH_GEODESICS_H_
+#define _MESH_GEODESICS_H_
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "dAryHeap.h"
+#include "functionHelpers.h"
+#include "meshAdjacency.h"
+
+// Distance fields along the surface of a mesh, computed from a set of source
+// vertices. Dijkstra propagates along edges and overestimates; fast marching
+// propagates a planar front across triangles and is close to the true
+// geodesic on well shaped meshes. Both stop expanding once the front passes
+// maxRadius, leaving the remaining vertices at infinity.
+template <class T, class U>
+class MeshGeodesics {
+ public:
+  typedef typename Mesh<T, U>::VIndex VIndex;
+  typedef typename Mesh<T, U>::CIndex CIndex;
+
+  enum class Method { DIJKSTRA, FAST_MARCHING };
+
+ private:
+  enum class VertexState : unsigned char { FAR, TRIAL, ALIVE };
+
+  // Per query scratch space. One per thread when running queries in parallel
+  struct Workspace {
+    IndexedDAryHeap<U, T> heap;
+    std::vector<VertexState> state;
+
+    explicit Workspace(T nv) : heap(nv), state(nv, VertexState::FAR) {}
+  };
+
+  const Mesh<T, U>& m_mesh;
+  MeshAdjacency<T, U> m_adjacency;
+
+ public:
+  explicit MeshGeodesics(const Mesh<T, U>& mesh)
+      : m_mesh(mesh), m_adjacency(mesh) {}
+
+  static U infinity() { return std::numeric_limits<U>::max(); }
+
+  // Distance from the nearest of sources to every vertex. Vertices farther than
+  // maxRadius are left at infinity()
+  void computeDistances(const std::vector<VIndex>& sources,
+                        std::vector<U>& distances,
+                        Method method = Method::FAST_MARCHING,
+                        U maxRadius = infinity()) const {
+    Workspace workspace(m_adjacency.numVertices());
+    computeDistances(sources, distances, method, maxRadius, workspace);
+  }
+
+  // Run one independent query per source set, spread across worker threads
+  void computeDistances(const std::vector<std::vector<VIndex>>& sourceSets,
+                        std::vector<std::vector<U>>& distanceFields,
+                        Method method = Method::FAST_MARCHING,
+                        U maxRadius = infinity()) const {
+    distanceFields.resize(sourceSets.size());
+    parallelFor<size_t>(
+        0, sourceSets.size(),
+        [this, &sourceSets, &distanceFields, &method, &maxRadius](
+            size_t begin, size_t end) {
+          Workspace workspace(m_adjacency.numVertices());
+          for (size_t query = begin; query < end; ++query) {
+            computeDistances(sourceSets[query], distanceFields[query], method,
+                             maxRadius, workspace);
+          }
+        },
+        size_t(1));
+  }
+
+  const MeshAdjacency<T, U>& adjacency() const throw() { return m_adjacency; }
+
+ private:
+  void computeDistances(const std::vector<VIndex>& sources,
+                        std::vector<U>& distances, Method method, U maxRadius,
+                        Workspace& workspace) const {
+    T nv = m_adjacency.numVertices();
+    distances.assign(nv, infinity());
+    std::fill(workspace.state.begin(), workspace.state.end(),
+              VertexState::FAR);
+    workspace.heap.clear();
+
+    for (const VIndex& source : sources) {
+      distances[source] = 0;
+      workspace.state[source] = VertexState::TRIAL;
+      workspace.heap.pushOrDecrease(source, U(0));
+    }
+
+    while (!workspace.heap.empty()) {
+      if (workspace.heap.topKey() > maxRadius) {
+        break;
+      }
+      T vertex = workspace.heap.pop();
+      workspace.state[vertex] = VertexState::ALIVE;
+      if (method == Method::DIJKSTRA) {
+        relaxEdges(vertex, distances, workspace);
+      } else {
+        relaxTriangles(vertex, distances, workspace);
+      }
+    }
+
+    // Anything left on the front lies beyond the radius
+    for (T vertex = 0; vertex < nv; ++vertex) {
+      if (workspace.state[vertex] != VertexState::ALIVE) {
+        distances[vertex] = infinity();
+      }
+    }
+  }
+
+  void relaxEdges(T vertex, std::vector<U>& distances,
+                  Workspace& workspace) const {
+    U base = distances[vertex];
+    for (T slot = m_adjacency.neighbourBegin(vertex);
+         slot < m_adjacency.neighbourEnd(vertex); ++slot) {
+      T neighbour = m_adjacency.neighbour(slot);
+      if (workspace.state[neighbour] == VertexState::ALIVE) {
+        continue;
+      }
+      update(neighbour, base + m_adjacency.edgeLength(slot), distances,
+             workspace);
+    }
+  }
+
+  void relaxTriangles(T vertex, std::vector<U>& distances,
+                      Workspace& workspace) const {
+    for (T slot = m_adjacency.cornerBegin(vertex);
+         slot < m_adjacency.cornerEnd(vertex); ++slot) {
+      CIndex corner = CIndex(m_adjacency.corner(slot));
+      T next = m_mesh.v(m_mesh.n(corner));
+      T prev = m_mesh.v(m_mesh.p(corner));
+      if (workspace.state[next] != VertexState::ALIVE) {
+        update(next, triangleUpdate(vertex, prev, next, distances, workspace),
+               distances, workspace);
+      }
+      if (workspace.state[prev] != VertexState::ALIVE) {
+        update(prev, triangleUpdate(vertex, next, prev, distances, workspace),
+               distances, workspace);
+      }
+    }
+  }
+
+  void update(T vertex, U candidate, std::vector<U>& distances,
+              Workspace& workspace) const {
+    if (candidate < distances[vertex]) {
+      distances[vertex] = candidate;
+      workspace.state[vertex] = VertexState::TRIAL;
+      workspace.heap.pushOrDecrease(vertex, candidate);
+    }
+  }
+
+  // Distance at target from the front through the triangle (alive, other,
+  // target). When other is not yet alive, or the virtual source does not see
+  // target through the edge (alive, other), fall back to the edge updates.
+  U triangleUpdate(T alive, T other, T target, const std::vector<U>& distances,
+                   const Workspace& workspace) const {
+    const Point<U>& a = m_mesh.geom(VIndex(alive));
+    const Point<U>& c = m_mesh.geom(VIndex(target));
+    U dA = distances[alive];
+    U edgeUpdate = dA + a.distance(c);
+    if (workspace.state[other] != VertexState::ALIVE) {
+      return edgeUpdate;
+    }
+
+    const Point<U>& b = m_mesh.geom(VIndex(other));
+    U dB = distances[other];
+    edgeUpdate = std::min(edgeUpdate, dB + b.distance(c));
+
+    // Local frame with a at the origin and b on the positive x axis
+    Vector<U> ab(a, b);
+    Vector<U> ac(a, c);
+    U lengthAB = ab.norm();
+    if (lengthAB <= std::numeric_limits<U>::epsilon()) {
+      return edgeUpdate;
+    }
+    U cx = ab.dot(ac) / lengthAB;
+    U cy2 = ac.sqnorm() - cx * cx;
+    U cy = cy2 > 0 ? std::sqrt(cy2) : U(0);
+
+    // Virtual source on the far side of ab from c
+    U sx = (dA * dA - dB * dB + lengthAB * lengthAB) / (2 * lengthAB);
+    U sy2 = dA * dA - sx * sx;
+    if (sy2 < 0) {
+      return edgeUpdate;
+    }
+    U sy = -std::sqrt(sy2);
+
+    // Upwind criterion: the ray from the source to c must cross ab
+    U k = -sy / (cy - sy);
+    U crossing = sx + k * (cx - sx);
+    if (crossing < 0 || crossing > lengthAB) {
+      return edgeUpdate;
+    }
+    U dx = cx - sx;
+    U dy = cy - sy;
+    return std::min(edgeUpdate, std::sqrt(dx * dx + dy * dy));
+  }
+};
+
+#endif  //_MESH_GEODESICS_H_
@@ -0,0 +1,178 @@
+#ifndef _MESH_SMOOTHING_H_
+#define _MESH_SMOOTHING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "functionHelpers.h"
+#include "meshAdjacency.h"
+
+// Laplacian and Taubin smoothing of mesh geometry. The one-ring weights are
+// precomputed once into CSR form from the O table and each iteration is a
+// Jacobi step from one set of SoA position buffers into the other, so vertices
+// can be processed independently across threads. Boundary vertices are kept
+// fixed. Normals and the bounding box are invalidated once at the end.
+template <class T, class U>
+class MeshSmoother {
+ public:
+  typedef typename Mesh<T, U>::VIndex VIndex;
+  typedef typename Mesh<T, U>::CIndex CIndex;
+
+  enum class Weighting { UNIFORM, COTANGENT };
+
+ private:
+  Mesh<T, U>& m_mesh;
+  MeshAdjacency<T, U> m_adjacency;
+  std::vector<U> m_weights;  // Row normalized, parallel to the neighbour slots
+  std::vector<bool> m_fFixed;
+
+  std::vector<U> m_position[2][3];  // Double buffered x, y, z arrays
+  int m_current;
+
+ public:
+  MeshSmoother(Mesh<T, U>& mesh, Weighting weighting = Weighting::UNIFORM)
+      : m_mesh(mesh), m_adjacency(mesh), m_current(0) {
+    computeWeights(weighting);
+    markBoundary();
+  }
+
+  // Each iteration moves every vertex by lambda times its Laplacian
+  void smoothLaplacian(int numIterations, U lambda) {
+    loadPositions();
+    for (int i = 0; i < numIterations; ++i) {
+      iterate(lambda);
+    }
+    storePositions();
+  }
+
+  // Alternating shrink (lambda > 0) and inflate (mu < -lambda) steps, which
+  // smooth without the shrinkage of plain Laplacian smoothing
+  void smoothTaubin(int numIterations, U lambda, U mu) {
+    loadPositions();
+    for (int i = 0; i < numIterations; ++i) {
+      iterate(lambda);
+      iterate(mu);
+    }
+    storePositions();
+  }
+
+ private:
+  void computeWeights(Weighting weighting) {
+    T nv = m_adjacency.numVertices();
+    m_weights.assign(m_adjacency.neighbours().size(), U(0));
+
+    if (weighting == Weighting::COTANGENT) {
+      // The edge opposite corner c gets half the cotangent of the angle at c
+      for (T c = 0; c < m_mesh.nc(); ++c) {
+        CIndex corner = CIndex(c);
+        T a = m_mesh.v(m_mesh.n(corner));
+        T b = m_mesh.v(m_mesh.p(corner));
+        U cotangent = std::max<U>(cotangentAt(corner), 0);
+        T slotAB = m_adjacency.findNeighbourSlot(a, b);
+        T slotBA = m_adjacency.findNeighbourSlot(b, a);
+        if (slotAB != -1 && slotBA != -1) {
+          m_weights[slotAB] += 0.5f * cotangent;
+          m_weights[slotBA] += 0.5f * cotangent;
+        }
+      }
+    }
+
+    parallelFor<T>(0, nv, [this, weighting](T begin, T end) {
+      for (T v = begin; v < end; ++v) {
+        T slotBegin = m_adjacency.neighbourBegin(v);
+        T slotEnd = m_adjacency.neighbourEnd(v);
+        U sum = 0;
+        for (T slot = slotBegin; slot < slotEnd; ++slot) {
+          sum += m_weights[slot];
+        }
+        // Uniform weights, and the fallback when all cotangents are obtuse
+        bool fUniform = weighting == Weighting::UNIFORM || sum <= 0;
+        U scale = fUniform ? U(1) / std::max<T>(slotEnd - slotBegin, 1)
+                           : U(1) / sum;
+        for (T slot = slotBegin; slot < slotEnd; ++slot) {
+          m_weights[slot] = fUniform ? scale : m_weights[slot] * scale;
+        }
+      }
+    });
+  }
+
+  U cotangentAt(CIndex corner) const {
+    Vector<U> e1(m_mesh.g(corner), m_mesh.g(m_mesh.n(corner)));
+    Vector<U> e2(m_mesh.g(corner), m_mesh.g(m_mesh.p(corner)));
+    U sine = e1.cross(e2).norm();
+    return sine > 0 ? e1.dot(e2) / sine : U(0);
+  }
+
+  void markBoundary() {
+    T nv = m_adjacency.numVertices();
+    m_fFixed.assign(nv, false);
+    for (T v = 0; v < nv; ++v) {
+      m_fFixed[v] = m_adjacency.neighbourBegin(v) == m_adjacency.neighbourEnd(v);
+    }
+    for (T c = 0; c < m_mesh.nc(); ++c) {
+      CIndex corner = CIndex(c);
+      if (m_mesh.o(corner) == -1) {
+        m_fFixed[m_mesh.v(m_mesh.n(corner))] = true;
+        m_fFixed[m_mesh.v(m_mesh.p(corner))] = true;
+      }
+    }
+  }
+
+  void loadPositions() {
+    T nv = m_adjacency.numVertices();
+    for (int buffer = 0; buffer < 2; ++buffer) {
+      for (int axis = 0; axis < 3; ++axis) {
+        m_position[buffer][axis].resize(nv);
+      }
+    }
+    m_current = 0;
+    parallelFor<T>(0, nv, [this](T begin, T end) {
+      for (T v = begin; v < end; ++v) {
+        const Point<U>& point = m_mesh.geom(VIndex(v));
+        m_position[0][0][v] = point.x();
+        m_position[0][1][v] = point.y();
+        m_position[0][2][v] = point.z();
+      }
+    });
+  }
+
+  void storePositions() {
+    const std::vector<U>* position = m_position[m_current];
+    m_mesh.setGeometry(position[0].data(), position[1].data(),
+                       position[2].data());
+  }
+
+  void iterate(U factor) {
+    const std::vector<T>& offsets = m_adjacency.neighbourOffsets();
+    const std::vector<T>& neighbours = m_adjacency.neighbours();
+    parallelFor<T>(0, m_adjacency.numVertices(), [&](T begin, T end) {
+      const U* __restrict inX = m_position[m_current][0].data();
+      const U* __restrict inY = m_position[m_current][1].data();
+      const U* __restrict inZ = m_position[m_current][2].data();
+      U* __restrict outX = m_position[1 - m_current][0].data();
+      U* __restrict outY = m_position[1 - m_current][1].data();
+      U* __restrict outZ = m_position[1 - m_current][2].data();
+      const T* __restrict neighbourData = neighbours.data();
+      const U* __restrict weightData = m_weights.data();
+
+      for (T v = begin; v < end; ++v) {
+        U averageX = 0, averageY = 0, averageZ = 0;
+        for (T slot = offsets[v]; slot < offsets[v + 1]; ++slot) {
+          T neighbour = neighbourData[slot];
+          U weight = weightData[slot];
+          averageX += weight * inX[neighbour];
+          averageY += weight * inY[neighbour];
+          averageZ += weight * inZ[neighbour];
+        }
+        U step = m_fFixed[v] ? U(0) : factor;
+        outX[v] = inX[v] + step * (averageX - inX[v]);
+        outY[v] = inY[v] + step * (averageY - inY[v]);
+        outZ[v] = inZ[v] + step * (averageZ - inZ[v]);
+      }
+    });
+    m_current = 1 - m_current;
+  }
+};
+
+#endif  //_MESH_SMOOTHING_H_
@@ -0,0 +1,258 @@
+#ifndef _MESH_STATISTICS_H_
+#define _MESH_STATISTICS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <vector>
+
+#include "functionHelpers.h"
+#include "mesh.h"
+
+const int c_numStatisticsBins = 32;
+
+// Mesh quality metrics. Histograms are dense arrays of counts:
+// - valenceHistogram[k] is the number of vertices with k incident corners
+// - edgeLengthHistogram[k] counts edges of length in (d / 2^(k+1), d / 2^k],
+//   where d is the bounding box diagonal
+// - triangleAreaHistogram[k] bins the square root of triangle areas the same
+//   way
+// - aspectRatioHistogram[k] counts triangles with aspect ratio in
+//   [2^(k/4), 2^((k+1)/4)); 1 is equilateral, degenerate ones land in the last
+//   bin
+template <class U>
+struct MeshStatistics {
+  std::vector<int> valenceHistogram;
+  std::vector<int> edgeLengthHistogram;
+  std::vector<int> triangleAreaHistogram;
+  std::vector<int> aspectRatioHistogram;
+
+  U minEdgeLength;
+  U maxEdgeLength;
+  U meanEdgeLength;
+  U totalArea;
+  U maxAspectRatio;
+  U boundaryLength;
+
+  int numVertices;
+  int numEdges;
+  int numTriangles;
+  int numBoundaryEdges;
+  int numBoundaryLoops;
+  int numComponents;
+  int eulerCharacteristic;  // V - E + F
+  int genus;  // Summed over components, assuming they are orientable manifolds
+};
+
+namespace MeshStatisticsDetail {
+class UnionFind {
+ private:
+  std::vector<int> m_parent;
+
+ public:
+  explicit UnionFind(int size) : m_parent(size) {
+    std::iota(m_parent.begin(), m_parent.end(), 0);
+  }
+
+  int find(int element) {
+    while (m_parent[element] != element) {
+      m_parent[element] = m_parent[m_parent[element]];
+      element = m_parent[element];
+    }
+    return element;
+  }
+
+  void unite(int a, int b) { m_parent[find(a)] = find(b); }
+};
+
+inline int logBin(double value, double reference) {
+  if (!(value > 0)) {
+    return c_numStatisticsBins - 1;
+  }
+  int bin = int(std::floor(-std::log2(value / reference)));
+  return clamp(bin, 0, c_numStatisticsBins - 1);
+}
+
+// Per thread accumulators of the triangle sweep, merged at the end
+template <class U>
+struct TriangleSweepPartial {
+  std::vector<int> edgeLengthHistogram;
+  std::vector<int> triangleAreaHistogram;
+  std::vector<int> aspectRatioHistogram;
+  U minEdgeLength;
+  U maxEdgeLength;
+  double sumEdgeLength;
+  double totalArea;
+  U maxAspectRatio;
+  double boundaryLength;
+  int numEdges;
+  int numBoundaryEdges;
+
+  TriangleSweepPartial()
+      : edgeLengthHistogram(c_numStatisticsBins),
+        triangleAreaHistogram(c_numStatisticsBins),
+        aspectRatioHistogram(c_numStatisticsBins),
+        minEdgeLength(std::numeric_limits<U>::max()),
+        maxEdgeLength(0),
+        sumEdgeLength(0),
+        totalArea(0),
+        maxAspectRatio(0),
+        boundaryLength(0),
+        numEdges(0),
+        numBoundaryEdges(0) {}
+
+  void merge(const TriangleSweepPartial& other) {
+    for (int bin = 0; bin < c_numStatisticsBins; ++bin) {
+      edgeLengthHistogram[bin] += other.edgeLengthHistogram[bin];
+      triangleAreaHistogram[bin] += other.triangleAreaHistogram[bin];
+      aspectRatioHistogram[bin] += other.aspectRatioHistogram[bin];
+    }
+    minEdgeLength = std::min(minEdgeLength, other.minEdgeLength);
+    maxEdgeLength = std::max(maxEdgeLength, other.maxEdgeLength);
+    sumEdgeLength += other.sumEdgeLength;
+    totalArea += other.totalArea;
+    maxAspectRatio = std::max(maxAspectRatio, other.maxAspectRatio);
+    boundaryLength += other.boundaryLength;
+    numEdges += other.numEdges;
+    numBoundaryEdges += other.numBoundaryEdges;
+  }
+};
+}  // namespace MeshStatisticsDetail
+
+// Computes all metrics in two sweeps: a parallel sweep over triangles for the
+// geometric measures, and a sequential sweep over corners for valences and the
+// connectivity (components, boundary loops) needed for the genus.
+template <class T, class U>
+MeshStatistics<U> computeMeshStatistics(const Mesh<T, U>& mesh) {
+  using namespace MeshStatisticsDetail;
+  typedef typename Mesh<T, U>::CIndex CIndex;
+  typedef typename Mesh<T, U>::TIndex TIndex;
+
+  MeshStatistics<U> statistics;
+  T nv = mesh.nv();
+  T nt = mesh.nt();
+
+  Point<float> boxSize = mesh.boundingBoxSize();
+  double diagonal = std::sqrt(double(boxSize.x()) * boxSize.x() +
+                              double(boxSize.y()) * boxSize.y() +
+                              double(boxSize.z()) * boxSize.z());
+  if (!(diagonal > 0)) {
+    diagonal = 1;
+  }
+
+  // Sweep 1: triangles
+  TriangleSweepPartial<U> total;
+  std::mutex mergeMutex;
+  parallelFor<T>(0, nt, [&](T begin, T end) {
+    TriangleSweepPartial<U> partial;
+    for (T t = begin; t < end; ++t) {
+      CIndex corner = mesh.c(TIndex(t));
+      U lengths[3];
+      U longest = 0;
+      for (int i = 0; i < 3; ++i) {
+        CIndex c = CIndex(corner + i);
+        lengths[i] = mesh.g(mesh.n(c)).distance(mesh.g(mesh.p(c)));
+        longest = std::max(longest, lengths[i]);
+
+        // The edge opposite c is counted from one side only
+        CIndex opposite = mesh.o(c);
+        if (opposite == -1 || c < opposite) {
+          partial.numEdges++;
+          partial.sumEdgeLength += lengths[i];
+          partial.minEdgeLength = std::min(partial.minEdgeLength, lengths[i]);
+          partial.maxEdgeLength = std::max(partial.maxEdgeLength, lengths[i]);
+          partial.edgeLengthHistogram[logBin(lengths[i], diagonal)]++;
+          if (opposite == -1) {
+            partial.numBoundaryEdges++;
+            partial.boundaryLength += lengths[i];
+          }
+        }
+      }
+
+      // Heron's formula
+      double s = 0.5 * (double(lengths[0]) + lengths[1] + lengths[2]);
+      double area2 = s * (s - lengths[0]) * (s - lengths[1]) * (s - lengths[2]);
+      double area = area2 > 0 ? std::sqrt(area2) : 0;
+      partial.totalArea += area;
+      partial.triangleAreaHistogram[logBin(std::sqrt(area), diagonal)]++;
+
+      // Longest edge over twice sqrt(3) times the inradius; 1 if equilateral
+      int aspectBin = c_numStatisticsBins - 1;
+      if (area > 0) {
+        double aspectRatio = longest * s / (2 * std::sqrt(3.0) * area);
+        partial.maxAspectRatio =
+            std::max<U>(partial.maxAspectRatio, U(aspectRatio));
+        aspectBin = clamp(int(4 * std::log2(aspectRatio)), 0,
+                          c_numStatisticsBins - 1);
+      } else {
+        partial.maxAspectRatio = std::numeric_limits<U>::infinity();
+      }
+      partial.aspectRatioHistogram[aspectBin]++;
+    }
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    total.merge(partial);
+  });
+
+  // Sweep 2: corners
+  std::vector<int> valence(nv, 0);
+  UnionFind components(nv);
+  UnionFind boundaryLoops(nv);
+  std::vector<bool> fOnBoundary(nv, false);
+  for (T corner = 0; corner < mesh.nc(); ++corner) {
+    CIndex c = CIndex(corner);
+    T vertex = mesh.v(c);
+    T next = mesh.v(mesh.n(c));
+    valence[vertex]++;
+    components.unite(vertex, next);
+    if (mesh.o(mesh.p(c)) == -1) {
+      // The edge (vertex, next) is opposite p(c) and lies on the boundary
+      boundaryLoops.unite(vertex, next);
+      fOnBoundary[vertex] = true;
+      fOnBoundary[next] = true;
+    }
+  }
+
+  int maxValence = nv > 0 ? *std::max_element(valence.begin(), valence.end())
+                          : 0;
+  statistics.valenceHistogram.assign(maxValence + 1, 0);
+  int numComponents = 0;
+  int numBoundaryLoops = 0;
+  for (T vertex = 0; vertex < nv; ++vertex) {
+    statistics.valenceHistogram[valence[vertex]]++;
+    // Isolated vertices do not form a surface component
+    if (valence[vertex] > 0 && components.find(vertex) == vertex) {
+      numComponents++;
+    }
+    if (fOnBoundary[vertex] && boundaryLoops.find(vertex) == vertex) {
+      numBoundaryLoops++;
+    }
+  }
+
+  statistics.edgeLengthHistogram = total.edgeLengthHistogram;
+  statistics.triangleAreaHistogram = total.triangleAreaHistogram;
+  statistics.aspectRatioHistogram = total.aspectRatioHistogram;
+  statistics.minEdgeLength = total.numEdges > 0 ? total.minEdgeLength : U(0);
+  statistics.maxEdgeLength = total.maxEdgeLength;
+  statistics.meanEdgeLength =
+      total.numEdges > 0 ? U(total.sumEdgeLength / total.numEdges) : U(0);
+  statistics.totalArea = U(total.totalArea);
+  statistics.maxAspectRatio = total.maxAspectRatio;
+  statistics.boundaryLength = U(total.boundaryLength);
+
+  statistics.numVertices = int(nv) - statistics.valenceHistogram[0];
+  statistics.numEdges = total.numEdges;
+  statistics.numTriangles = int(nt);
+  statistics.numBoundaryEdges = total.numBoundaryEdges;
+  statistics.numBoundaryLoops = numBoundaryLoops;
+  statistics.numComponents = numComponents;
+  statistics.eulerCharacteristic =
+      statistics.numVertices - statistics.numEdges + statistics.numTriangles;
+  // chi = sum over components of (2 - 2g - b)
+  statistics.genus = std::max(0, (2 * numComponents - numBoundaryLoops -
+                                  statistics.eulerCharacteristic) / 2);
+  return statistics;
+}
+
+#endif  //_MESH_STATISTICS_H_
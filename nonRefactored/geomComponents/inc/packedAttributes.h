@@ -0,0 +1,95 @@
+#ifndef _PACKED_ATTRIBUTES_H_
+#define _PACKED_ATTRIBUTES_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "numHelpers.h"
+
+// Vertex formats for GPU buffers
+enum class AttributePrecision {
+  FULL,    // float positions and normals: 24 bytes per vertex
+  PACKED,  // 16 bit positions, 10:10:10:2 normals: 12 bytes per vertex
+};
+
+// Maps 16 bit quantized positions back to model space; set as a translation
+// and uniform scale on the modelview matrix when drawing
+template <class U>
+struct PositionDequantization {
+  U offset[3];
+  U scale;
+};
+
+const int c_positionBits = 16;
+const int c_positionBias = 1 << (c_positionBits - 1);
+
+// Dequantization for 16 bit positions in the cube around the bounding box
+// (low, high), so that it is a uniform scale and leaves normals undistorted.
+// The 2^16 codes span the cube with the step of quantizeValues; the offset is
+// half a step off the centre since the signed codes run from -2^15 to 2^15 - 1
+template <class U>
+PositionDequantization<U> positionDequantization16(const U low[3],
+                                                   const U high[3]) {
+  U halfSize = 0;
+  for (int axis = 0; axis < 3; ++axis) {
+    halfSize = std::max(halfSize, U(0.5) * (high[axis] - low[axis]));
+  }
+  if (!(halfSize > 0)) {
+    halfSize = 1;
+  }
+  PositionDequantization<U> dequantization;
+  dequantization.scale = quantizationStep(-halfSize, halfSize, c_positionBits);
+  for (int axis = 0; axis < 3; ++axis) {
+    dequantization.offset[axis] =
+        U(0.5) * (low[axis] + high[axis]) + U(0.5) * dequantization.scale;
+  }
+  return dequantization;
+}
+
+// Quantize count x y z positions to signed 16 bit values, one axis at a time
+// with the batch kernels and biased by -2^15. Writes 4 shorts per position,
+// the fourth as padding, since GL wants attributes 4 byte aligned.
+template <class U>
+void quantizePositions16(const U* __restrict positions, size_t count,
+                         const PositionDequantization<U>& dequantization,
+                         int16_t* __restrict out) {
+  std::vector<U> coordinates(count);
+  std::vector<uint16_t> codes(count);
+  for (int axis = 0; axis < 3; ++axis) {
+    U cubeLow =
+        dequantization.offset[axis] - dequantization.scale * c_positionBias;
+    U cubeHigh = cubeLow + dequantization.scale * (2 * c_positionBias - 1);
+    for (size_t i = 0; i < count; ++i) {
+      coordinates[i] = positions[3 * i + axis];
+    }
+    quantizeValues(coordinates.data(), count, cubeLow, cubeHigh,
+                   c_positionBits, codes.data());
+    for (size_t i = 0; i < count; ++i) {
+      out[4 * i + axis] = int16_t(int(codes[i]) - c_positionBias);
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    out[4 * i + 3] = 0;
+  }
+}
+
+// Pack unit normals into GL_INT_2_10_10_10_REV: signed normalized x, y, z in
+// bits 0-9, 10-19 and 20-29, w unused
+template <class U>
+void packNormals2101010(const U* __restrict normals, size_t count,
+                        uint32_t* __restrict out) {
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t packed = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+      U value = clamp<U>(normals[3 * i + axis], -1, 1);
+      int32_t quantized = int32_t(std::lround(value * 511));
+      packed |= (uint32_t(quantized) & 0x3ff) << (10 * axis);
+    }
+    out[i] = packed;
+  }
+}
+
+#endif  //_PACKED_ATTRIBUTES_H_
@@ -0,0 +1,43 @@
+#ifndef _QUATERNION_H_
+#define _QUATERNION_H_
+
+#include "matrix.h"
+
+// Rotation stored as a unit quaternion w + xi + yj + zk. Rotations compose with 16 multiplies
+// instead of the 64 of a 4x4 product, drift is removed by renormalizing, and two rotations
+// interpolate along the shortest arc with slerp.
+class Quaternion
+{
+public:
+  Quaternion() throw() : m_w(1), m_x(0), m_y(0), m_z(0) {}
+  Quaternion(float w, float x, float y, float z) throw() : m_w(w), m_x(x), m_y(y), m_z(z) {}
+  Quaternion(const Vector<float>& axis, float angle); //Rotation by angle about the unit axis, as Matrix::rotate
+  // Rotation part of a rigid matrix
+  static Quaternion fromMatrix(const Matrix& matrix);
+
+  float w() const throw() { return m_w; }
+  float x() const throw() { return m_x; }
+  float y() const throw() { return m_y; }
+  float z() const throw() { return m_z; }
+
+  // This rotation followed by other is other * (*this), as for matrices acting on column vectors
+  Quaternion operator*(const Quaternion& other) const throw();
+  Quaternion conjugate() const throw() { return Quaternion(m_w, -m_x, -m_y, -m_z); }
+  float dot(const Quaternion& other) const throw();
+  void normalize() throw();
+
+  Vector<float> rotate(const Vector<float>& vector) const throw();
+  // The rigid matrix rotating by this and then translating by translation
+  Matrix toMatrix(const Vector<float>& translation) const throw();
+
+  // Spherical interpolation from from (t = 0) to to (t = 1) along the shorter arc
+  static Quaternion slerp(const Quaternion& from, const Quaternion& to, float t) throw();
+
+private:
+  float m_w;
+  float m_x;
+  float m_y;
+  float m_z;
+};
+
+#endif //_QUATERNION_H_
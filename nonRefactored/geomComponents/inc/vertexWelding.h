@@ -0,0 +1,218 @@
+#ifndef _VERTEX_WELDING_H_
+#define _VERTEX_WELDING_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "functionHelpers.h"
+
+namespace VertexWeldingDetail {
+const int c_bitsPerAxis = 21;
+const uint64_t c_maxCell = (uint64_t(1) << c_bitsPerAxis) - 1;
+const uint64_t c_emptyCellKey = ~uint64_t(0);  // Not a valid key
+
+inline uint64_t cellKey(uint64_t x, uint64_t y, uint64_t z) {
+  return (x << (2 * c_bitsPerAxis)) | (y << c_bitsPerAxis) | z;
+}
+
+// Open addressing map from a cell key to the first slot of that cell in the
+// sorted (key, vertex) array. Built once, then only read, so lookups from
+// many threads need no locking.
+template <class T>
+class CellTable {
+ private:
+  std::vector<uint64_t> m_keys;
+  std::vector<T> m_starts;
+  uint64_t m_mask;
+
+  static uint64_t slotFor(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+ public:
+  explicit CellTable(size_t numCells) {
+    size_t capacity = 16;
+    while (capacity < 2 * numCells) {
+      capacity *= 2;
+    }
+    m_keys.assign(capacity, c_emptyCellKey);
+    m_starts.resize(capacity);
+    m_mask = capacity - 1;
+  }
+
+  void insert(uint64_t key, T start) {
+    uint64_t slot = slotFor(key) & m_mask;
+    while (m_keys[slot] != c_emptyCellKey) {
+      slot = (slot + 1) & m_mask;
+    }
+    m_keys[slot] = key;
+    m_starts[slot] = start;
+  }
+
+  // First slot of the cell, or -1 if the cell is empty
+  T find(uint64_t key) const {
+    uint64_t slot = slotFor(key) & m_mask;
+    while (m_keys[slot] != c_emptyCellKey) {
+      if (m_keys[slot] == key) {
+        return m_starts[slot];
+      }
+      slot = (slot + 1) & m_mask;
+    }
+    return T(-1);
+  }
+};
+}  // namespace VertexWeldingDetail
+
+// Finds vertices lying within epsilon of each other. Each vertex joins the
+// cluster of the lowest indexed vertex within epsilon of it, and on return
+// representative[v] is the lowest index in v's cluster. Returns the number of
+// clusters.
+//
+// Positions are quantized into cells of 8 * epsilon, so every neighbour of a
+// vertex lies in its own cell or in one of the (usually few) adjacent cells on
+// the sides it is within epsilon of. Vertices are sorted by cell key and the
+// start of each cell is hashed. The search then runs in parallel in sorted
+// order over a sorted copy of the positions, so that most memory accesses are
+// to the vertex's own cell and stay in cache.
+template <class T, class U>
+T computeWeldRepresentatives(const std::vector<Point<U>>& points, U epsilon,
+                             std::vector<T>& representative) {
+  using namespace VertexWeldingDetail;
+  T numPoints = T(points.size());
+  representative.resize(numPoints);
+  if (numPoints == 0) {
+    return 0;
+  }
+
+  U low[3] = {points[0].x(), points[0].y(), points[0].z()};
+  U high[3] = {low[0], low[1], low[2]};
+  for (T v = 0; v < numPoints; ++v) {
+    const Point<U>& point = points[v];
+    U coordinates[3] = {point.x(), point.y(), point.z()};
+    for (int axis = 0; axis < 3; ++axis) {
+      low[axis] = std::min(low[axis], coordinates[axis]);
+      high[axis] = std::max(high[axis], coordinates[axis]);
+    }
+  }
+
+  // Larger cells are still correct, only slower, so grow them if the box
+  // would not fit into the key
+  double cellSize = 8.0 * epsilon;
+  for (int axis = 0; axis < 3; ++axis) {
+    cellSize =
+        std::max(cellSize, double(high[axis] - low[axis]) / (c_maxCell - 1));
+  }
+  double inverseCellSize = 1.0 / cellSize;
+
+  std::vector<std::pair<uint64_t, T>> cells(numPoints);
+  parallelFor<T>(0, numPoints, [&](T begin, T end) {
+    for (T v = begin; v < end; ++v) {
+      const Point<U>& point = points[v];
+      uint64_t x = uint64_t((point.x() - low[0]) * inverseCellSize);
+      uint64_t y = uint64_t((point.y() - low[1]) * inverseCellSize);
+      uint64_t z = uint64_t((point.z() - low[2]) * inverseCellSize);
+      cells[v] = std::make_pair(cellKey(x, y, z), v);
+    }
+  });
+  parallelSort(cells.begin(), cells.end(),
+               [](const std::pair<uint64_t, T>& a,
+                  const std::pair<uint64_t, T>& b) { return a < b; });
+
+  size_t numCells = 0;
+  for (T slot = 0; slot < numPoints; ++slot) {
+    numCells += slot == 0 || cells[slot].first != cells[slot - 1].first;
+  }
+  CellTable<T> cellTable(numCells);
+  for (T slot = 0; slot < numPoints; ++slot) {
+    if (slot == 0 || cells[slot].first != cells[slot - 1].first) {
+      cellTable.insert(cells[slot].first, slot);
+    }
+  }
+
+  std::vector<U> sortedCoordinates(3 * size_t(numPoints));
+  parallelFor<T>(0, numPoints, [&](T begin, T end) {
+    for (T slot = begin; slot < end; ++slot) {
+      const Point<U>& point = points[cells[slot].second];
+      sortedCoordinates[3 * size_t(slot)] = point.x();
+      sortedCoordinates[3 * size_t(slot) + 1] = point.y();
+      sortedCoordinates[3 * size_t(slot) + 2] = point.z();
+    }
+  });
+
+  // Lowest index within epsilon, including the vertex itself
+  double epsilon2 = double(epsilon) * epsilon;
+  std::vector<T> closestLower(numPoints);
+  parallelFor<T>(0, numPoints, [&](T begin, T end) {
+    for (T vertexSlot = begin; vertexSlot < end; ++vertexSlot) {
+      T v = cells[vertexSlot].second;
+      const U* point = &sortedCoordinates[3 * size_t(vertexSlot)];
+      double coordinates[3] = {double(point[0]), double(point[1]),
+                               double(point[2])};
+      int64_t cell[3];
+      int side[3];
+      for (int axis = 0; axis < 3; ++axis) {
+        double offset = (coordinates[axis] - low[axis]) * inverseCellSize;
+        cell[axis] = int64_t(offset);
+        double inCell = (offset - cell[axis]) * cellSize;
+        side[axis] =
+            inCell < epsilon ? -1 : (inCell > cellSize - epsilon ? 1 : 0);
+      }
+
+      T lowest = v;
+      for (int neighbour = 0; neighbour < 8; ++neighbour) {
+        int64_t neighbourCell[3];
+        bool fSkip = false;
+        for (int axis = 0; axis < 3; ++axis) {
+          int step = (neighbour >> axis) & 1 ? side[axis] : 0;
+          fSkip |= ((neighbour >> axis) & 1) && step == 0;
+          neighbourCell[axis] = cell[axis] + step;
+          fSkip |= neighbourCell[axis] < 0 ||
+                   neighbourCell[axis] > int64_t(c_maxCell);
+        }
+        if (fSkip) {
+          continue;
+        }
+        uint64_t key = cellKey(neighbourCell[0], neighbourCell[1],
+                               neighbourCell[2]);
+        T slot = cellTable.find(key);
+        if (slot == T(-1)) {
+          continue;
+        }
+        for (; slot < numPoints && cells[slot].first == key; ++slot) {
+          T other = cells[slot].second;
+          if (other >= lowest) {
+            continue;
+          }
+          const U* otherPoint = &sortedCoordinates[3 * size_t(slot)];
+          double dx = coordinates[0] - otherPoint[0];
+          double dy = coordinates[1] - otherPoint[1];
+          double dz = coordinates[2] - otherPoint[2];
+          if (dx * dx + dy * dy + dz * dz <= epsilon2) {
+            lowest = other;
+          }
+        }
+      }
+      closestLower[v] = lowest;
+    }
+  });
+
+  // closestLower[v] <= v, so one ascending pass resolves chains to the root
+  T numClusters = 0;
+  for (T v = 0; v < numPoints; ++v) {
+    if (closestLower[v] == v) {
+      representative[v] = v;
+      numClusters++;
+    } else {
+      representative[v] = representative[closestLower[v]];
+    }
+  }
+  return numClusters;
+}
+
+#endif  //_VERTEX_WELDING_H_
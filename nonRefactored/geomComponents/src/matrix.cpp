@@ -1,14 +1,107 @@
 #include "precomp.h"
 #include "Matrix.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATRIX_SSE
+#include <xmmintrin.h>
+#endif
+
+const size_t Matrix::c_minPointsPerThread;
+
+namespace
+{
+// pOut[i] = m * (pIn[i], w) for count packed xyz triples, keeping the top three rows
+void transformPacked(const float (&m)[4][4], float w, const float* pIn, float* pOut, size_t count)
+{
+  size_t i = 0;
+#ifdef MATRIX_SSE
+  __m128 m00 = _mm_set1_ps(m[0][0]), m01 = _mm_set1_ps(m[0][1]), m02 = _mm_set1_ps(m[0][2]), m03 = _mm_set1_ps(w * m[0][3]);
+  __m128 m10 = _mm_set1_ps(m[1][0]), m11 = _mm_set1_ps(m[1][1]), m12 = _mm_set1_ps(m[1][2]), m13 = _mm_set1_ps(w * m[1][3]);
+  __m128 m20 = _mm_set1_ps(m[2][0]), m21 = _mm_set1_ps(m[2][1]), m22 = _mm_set1_ps(m[2][2]), m23 = _mm_set1_ps(w * m[2][3]);
+  // Four points at a time: three registers hold x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3, which
+  // are shuffled into one register per coordinate and back
+  for (; i + 4 <= count; i += 4)
+  {
+    const float* pBlock = pIn + 3 * i;
+    __m128 a = _mm_loadu_ps(pBlock);
+    __m128 b = _mm_loadu_ps(pBlock + 4);
+    __m128 c = _mm_loadu_ps(pBlock + 8);
+    __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+                              _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+
+    __m128 outX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m00, x), _mm_mul_ps(m01, y)), _mm_add_ps(_mm_mul_ps(m02, z), m03));
+    __m128 outY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m10, x), _mm_mul_ps(m11, y)), _mm_add_ps(_mm_mul_ps(m12, z), m13));
+    __m128 outZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m20, x), _mm_mul_ps(m21, y)), _mm_add_ps(_mm_mul_ps(m22, z), m23));
+
+    float* pOutBlock = pOut + 3 * i;
+    _mm_storeu_ps(pOutBlock, _mm_shuffle_ps(_mm_shuffle_ps(outX, outY, _MM_SHUFFLE(0, 0, 0, 0)),
+                                            _mm_shuffle_ps(outZ, outX, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(pOutBlock + 4, _mm_shuffle_ps(_mm_shuffle_ps(outY, outZ, _MM_SHUFFLE(1, 1, 1, 1)),
+                                                _mm_shuffle_ps(outX, outY, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(pOutBlock + 8, _mm_shuffle_ps(_mm_shuffle_ps(outZ, outX, _MM_SHUFFLE(3, 3, 2, 2)),
+                                                _mm_shuffle_ps(outY, outZ, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+#endif
+  for (; i < count; i++)
+  {
+    float x = pIn[3 * i];
+    float y = pIn[3 * i + 1];
+    float z = pIn[3 * i + 2];
+    for (int row = 0; row < 3; row++)
+    {
+      pOut[3 * i + row] = m[row][0] * x + m[row][1] * y + m[row][2] * z + w * m[row][3];
+    }
+  }
+}
+
+// The product of an affine matrix with a homogeneous point or vector, whose w is left as is
+template <class T>
+T applyAffine(const float (&m)[4][4], const T& in)
+{
+  T out;
+  for (int i = 0; i < 3; i++)
+  {
+    out.set(i, m[i][0] * in.get(0) + m[i][1] * in.get(1) + m[i][2] * in.get(2) + m[i][3] * in.get(3));
+  }
+  out.set(3, in.get(3));
+  return out;
+}
+
+// The product of a general matrix with a homogeneous point or vector
+template <class T>
+T applyGeneral(const float (&m)[4][4], const T& in)
+{
+  T out;
+  for (int i = 0; i < 4; i++)
+  {
+    float sum = 0;
+    for (int j = 0; j < 4; j++)
+    {
+      sum += m[i][j] * in.get(j);
+    }
+    out.set(i, sum);
+  }
+  return out;
+}
+}
+
 Matrix::Matrix(const float matrix[][4])
 {
   setMatrix(matrix);
 }
 
+Matrix::Matrix(const float matrix[][4], Kind kind)
+{
+  setMatrix(matrix);
+  m_kind = kind;
+}
+
 Matrix::Matrix(const Matrix& other)
 {
   setMatrix(other.m_elements);
+  m_kind = other.m_kind;
 }
 
 Matrix::Matrix(const Vector<float>& x, const Vector<float>& y, const Vector<float>& z)
@@ -25,31 +118,81 @@ Matrix::Matrix(const Vector<float>& x, const Vector<float>& y, const Vector<floa
   m_elements[2][0] = x.z();
   m_elements[2][1] = y.z();
   m_elements[2][2] = z.z();
+
+  // Rigid only if the basis is orthonormal and right handed
+  const float c_tolerance = 1e-5f;
+  m_kind = Kind::RIGID;
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 3; j++)
+    {
+      float dot = m_elements[0][i] * m_elements[0][j] + m_elements[1][i] * m_elements[1][j] + m_elements[2][i] * m_elements[2][j];
+      if (fabs(dot - (i == j ? 1 : 0)) > c_tolerance)
+      {
+        m_kind = Kind::AFFINE;
+      }
+    }
+  }
+  float det = m_elements[0][0] * (m_elements[1][1] * m_elements[2][2] - m_elements[1][2] * m_elements[2][1]) -
+    m_elements[0][1] * (m_elements[1][0] * m_elements[2][2] - m_elements[1][2] * m_elements[2][0]) +
+    m_elements[0][2] * (m_elements[1][0] * m_elements[2][1] - m_elements[1][1] * m_elements[2][0]);
+  if (det < 0)
+  {
+    m_kind = Kind::AFFINE;
+  }
 }
 
 void Matrix::setMatrix(const float matrix[][4])
 {
   std::copy(&matrix[0][0], &matrix[0][0] + 16, stdext::checked_array_iterator<float*>(&m_elements[0][0], 16));
+  bool fAffine = m_elements[3][0] == 0 && m_elements[3][1] == 0 && m_elements[3][2] == 0 && m_elements[3][3] == 1;
+  m_kind = fAffine ? Kind::AFFINE : Kind::GENERAL;
+  m_fTransposedValid = false;
 }
 
-void Matrix::setZero()
+void Matrix::setZero() throw()
 {
   std::fill(&m_elements[0][0], &m_elements[0][0] + 16, 0);
+  m_kind = Kind::GENERAL;
+  m_fTransposedValid = false;
 }
 
-void Matrix::setIdentity()
+void Matrix::setIdentity() throw()
 {
   setZero();
   for (int i = 0; i < 4; i++)
   {
     m_elements[i][i] = 1;
   }
+  m_kind = Kind::RIGID;
 }
 
 Matrix Matrix::operator*(const Matrix& matrix2) const throw()
 {
   Matrix result;
-  for (int i = 0; i < 4; i++)
+  result.m_kind = std::max(m_kind, matrix2.m_kind);
+  // The bottom row of a product of affine matrices is known
+  int numRows = 4;
+  if (result.m_kind != Kind::GENERAL)
+  {
+    numRows = 3;
+    result.m_elements[3][3] = 1;
+  }
+#ifdef MATRIX_SSE
+  // Row i of the product is the combination of the rows of matrix2 weighted by row i of this
+  __m128 row0 = _mm_loadu_ps(matrix2.m_elements[0]);
+  __m128 row1 = _mm_loadu_ps(matrix2.m_elements[1]);
+  __m128 row2 = _mm_loadu_ps(matrix2.m_elements[2]);
+  __m128 row3 = _mm_loadu_ps(matrix2.m_elements[3]);
+  for (int i = 0; i < numRows; i++)
+  {
+    const float* pRow = m_elements[i];
+    __m128 sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[0]), row0), _mm_mul_ps(_mm_set1_ps(pRow[1]), row1));
+    sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(pRow[2]), row2), _mm_mul_ps(_mm_set1_ps(pRow[3]), row3)));
+    _mm_storeu_ps(result.m_elements[i], sum);
+  }
+#else
+  for (int i = 0; i < numRows; i++)
   {
     for (int j = 0; j < 4; j++)
     {
@@ -59,48 +202,67 @@ Matrix Matrix::operator*(const Matrix& matrix2) const throw()
       }
     }
   }
+#endif
   return result;
 }
 
+// The axis is normalized, so the result stays rigid whatever its length; a zero axis leaves the matrix unchanged
 void Matrix::rotate(const Vector<float>& axis, float angle)
 {
+  double length = sqrt(double(axis.x()) * axis.x() + double(axis.y()) * axis.y() + double(axis.z()) * axis.z());
+  if (length == 0)
+  {
+    return;
+  }
+  double x = axis.x() / length;
+  double y = axis.y() / length;
+  double z = axis.z() / length;
   double c = cos(angle);
   double s = sin(angle);
   Matrix rotationMatrix;
-  float matrix[4][4] = { c + axis.x()*axis.x()*(1 - c), axis.x()*axis.y()*(1 - c) - axis.z() * s, axis.x() * axis.z()*(1 - c) + axis.y()*s, 0,
-    axis.x() * axis.y() * (1 - c) + axis.z() * s, c + axis.y() * axis.y() * (1 - c), axis.y() * axis.z() * (1 - c) - axis.x() * s, 0,
-    axis.x() * axis.z() * (1 - c) - axis.y() * s, axis.y() * axis.z() * (1 - c) + axis.x() * s, c + axis.z() * axis.z() * (1 - c), 0,
+  float matrix[4][4] = { float(c + x * x * (1 - c)), float(x * y * (1 - c) - z * s), float(x * z * (1 - c) + y * s), 0,
+    float(x * y * (1 - c) + z * s), float(c + y * y * (1 - c)), float(y * z * (1 - c) - x * s), 0,
+    float(x * z * (1 - c) - y * s), float(y * z * (1 - c) + x * s), float(c + z * z * (1 - c)), 0,
     0, 0, 0, 1
   };
   rotationMatrix.setMatrix(matrix);
+  rotationMatrix.m_kind = Kind::RIGID;
   *this = rotationMatrix * (*this);
 }
 
 void Matrix::translate(const Vector<float>& vector)
 {
   Matrix translationMatrix;
-  float matrix[4][4] = { 0, 0, 0, vector.x(),
-    0, 0, 0, vector.y(),
-    0, 0, 0, vector.z(),
+  float matrix[4][4] = { 1, 0, 0, vector.x(),
+    0, 1, 0, vector.y(),
+    0, 0, 1, vector.z(),
     0, 0, 0, 1 };
   translationMatrix.setMatrix(matrix);
+  translationMatrix.m_kind = Kind::RIGID;
   *this = translationMatrix * (*this);
 }
 
-// From local coordinates to world coordinates X' = AX
-Point<float> Matrix::transformPoint(const Point<float>& untransformed) const throw()
+// Uniform scaling applied after this transform
+void Matrix::scale(float factor) throw()
 {
-  Point<float> returnValue;
-  for (int i = 0; i < 4; i++)
+  for (int i = 0; i < 3; i++)
   {
-    float sum = 0;
     for (int j = 0; j < 4; j++)
     {
-      sum += m_elements[i][j] * untransformed.get(j);
+      m_elements[i][j] *= factor;
     }
-    returnValue.set(i, sum);
   }
-  return returnValue;
+  if (m_kind == Kind::RIGID && factor != 1)
+  {
+    m_kind = Kind::AFFINE;
+  }
+  m_fTransposedValid = false;
+}
+
+// From local coordinates to world coordinates X' = AX
+Point<float> Matrix::transformPoint(const Point<float>& untransformed) const throw()
+{
+  return m_kind == Kind::GENERAL ? applyGeneral(m_elements, untransformed) : applyAffine(m_elements, untransformed);
 }
 
 // From world to local coordinates X' = A-1X
@@ -108,64 +270,147 @@ Point<float> Matrix::untransformPoint(const Point<float>& transformed) const thr
 {
   Matrix inverted(*this);
   inverted.invert();
-  Point<float> returnValue;
-  for (int i = 0; i < 4; i++)
+  return inverted.transformPoint(transformed);
+}
+
+Vector<float> Matrix::transformVector(const Vector<float>& untransformed) const throw()
+{
+  return m_kind == Kind::GENERAL ? applyGeneral(m_elements, untransformed) : applyAffine(m_elements, untransformed);
+}
+
+Vector<float> Matrix::untransformVector(const Vector<float>& transformed) const throw()
+{
+  Matrix inverted(*this);
+  inverted.invert();
+  return inverted.transformVector(transformed);
+}
+
+const float* Matrix::getAsGLArray() const throw()
+{
+  if (!m_fTransposedValid)
   {
-    float sum = 0;
-    for (int j = 0; j < 4; j++)
+#ifdef MATRIX_SSE
+    __m128 row0 = _mm_loadu_ps(m_elements[0]);
+    __m128 row1 = _mm_loadu_ps(m_elements[1]);
+    __m128 row2 = _mm_loadu_ps(m_elements[2]);
+    __m128 row3 = _mm_loadu_ps(m_elements[3]);
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    _mm_storeu_ps(m_elementsTransposed[0], row0);
+    _mm_storeu_ps(m_elementsTransposed[1], row1);
+    _mm_storeu_ps(m_elementsTransposed[2], row2);
+    _mm_storeu_ps(m_elementsTransposed[3], row3);
+#else
+    for (int i = 0; i < 4; i++)
     {
-      sum += inverted.m_elements[i][j] * transformed.get(j);
+      for (int j = 0; j < 4; j++)
+      {
+        m_elementsTransposed[i][j] = m_elements[j][i];
+      }
     }
-    returnValue.set(i, sum);
+#endif
+    m_fTransposedValid = true;
   }
-  return returnValue;
+  return &m_elementsTransposed[0][0];
 }
 
-Vector<float> Matrix::transformVector(const Vector<float>& untransformed) const throw()
+void Matrix::transformPoints(const float* pIn, float* pOut, size_t count) const throw()
 {
-  Vector<float> returnValue;
-  for (int i = 0; i < 4; i++)
+  parallelFor<size_t>(0, count, [this, pIn, pOut](size_t begin, size_t end)
   {
-    float sum = 0;
-    for (int j = 0; j < 4; j++)
+    transformPacked(m_elements, 1, pIn + 3 * begin, pOut + 3 * begin, end - begin);
+  }, c_minPointsPerThread);
+}
+
+void Matrix::transformVectors(const float* pIn, float* pOut, size_t count) const throw()
+{
+  parallelFor<size_t>(0, count, [this, pIn, pOut](size_t begin, size_t end)
+  {
+    transformPacked(m_elements, 0, pIn + 3 * begin, pOut + 3 * begin, end - begin);
+  }, c_minPointsPerThread);
+}
+
+// Plain loops over separate arrays, which the compiler vectorizes at the widest available width
+void Matrix::transformPoints(float* pX, float* pY, float* pZ, size_t count) const throw()
+{
+  const float (&m)[4][4] = m_elements;
+  parallelFor<size_t>(0, count, [&m, pX, pY, pZ](size_t begin, size_t end)
+  {
+    float* __restrict pOutX = pX;
+    float* __restrict pOutY = pY;
+    float* __restrict pOutZ = pZ;
+    for (size_t i = begin; i < end; i++)
     {
-      sum += m_elements[i][j] * untransformed.get(j);
+      float x = pOutX[i];
+      float y = pOutY[i];
+      float z = pOutZ[i];
+      pOutX[i] = m[0][0] * x + m[0][1] * y + m[0][2] * z + m[0][3];
+      pOutY[i] = m[1][0] * x + m[1][1] * y + m[1][2] * z + m[1][3];
+      pOutZ[i] = m[2][0] * x + m[2][1] * y + m[2][2] * z + m[2][3];
     }
-    returnValue.set(i, sum);
-  }
-  return returnValue;
+  }, c_minPointsPerThread);
 }
 
-Vector<float> Matrix::untransformVector(const Vector<float>& transformed) const throw()
+// Rigid transforms are inverted by transposing the rotation and affine ones through the 3x3
+// adjugate; both then take the translation to -A-1 t. Singular matrices are left unchanged.
+void Matrix::invert()
 {
-  Matrix inverted(*this);
-  inverted.invert();
-  Vector<float> returnValue;
-  for (int i = 0; i < 4; i++)
+  if (m_kind == Kind::GENERAL)
   {
-    float sum = 0;
-    for (int j = 0; j < 4; j++)
+    invertGeneral();
+    return;
+  }
+
+  float (&m)[4][4] = m_elements;
+  float inv[3][3];
+  if (m_kind == Kind::RIGID)
+  {
+    for (int i = 0; i < 3; i++)
     {
-      sum += inverted.m_elements[i][j] * transformed.get(j);
+      for (int j = 0; j < 3; j++)
+      {
+        inv[i][j] = m[j][i];
+      }
+    }
+  }
+  else
+  {
+    inv[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    inv[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    inv[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    inv[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    inv[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    inv[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    inv[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    inv[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    inv[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    float det = m[0][0] * inv[0][0] + m[0][1] * inv[1][0] + m[0][2] * inv[2][0];
+    if (det == 0)
+      return;
+
+    det = 1.0f / det;
+    for (int i = 0; i < 3; i++)
+    {
+      for (int j = 0; j < 3; j++)
+      {
+        inv[i][j] *= det;
+      }
     }
-    returnValue.set(i, sum);
   }
-  return returnValue;
-}
 
-const float* Matrix::getAsGLArray()
-{
-  for (int i = 0; i < 4; i++)
+  float translation[3] = { m[0][3], m[1][3], m[2][3] };
+  for (int i = 0; i < 3; i++)
   {
-    for (int j = 0; j < 4; j++)
+    for (int j = 0; j < 3; j++)
     {
-      m_elementsTransposed[i][j] = m_elements[j][i];
+      m[i][j] = inv[i][j];
     }
+    m[i][3] = -(inv[i][0] * translation[0] + inv[i][1] * translation[1] + inv[i][2] * translation[2]);
   }
-  return &m_elementsTransposed[0][0];
+  m_fTransposedValid = false;
 }
 
-void Matrix::invert()
+void Matrix::invertGeneral()
 {
   float inv[16], det;
   int i;
@@ -292,4 +537,5 @@ void Matrix::invert()
 
   for (i = 0; i < 16; i++)
     m[i] = inv[i] * det;
+  m_fTransposedValid = false;
 }
\ No newline at end of file
@@ -3,22 +3,25 @@
 
 template <typename T, typename U>
 void Mesh<T, U>::populateAuxMembers() {
-  m_vm.resize(m_nv);
-  m_fVRemoved.resize(m_nv);
-  m_tm.resize(m_nt);
-  resetMarkers();
-  setColorMap();
-  populateNormals();
+  // Markers, the colour map, normals and the bounding box are materialized
+  // on first use. Drop the markers of any previously loaded mesh.
+  invalidateDerivedData(DERIVED_MARKERS);
+  m_vm.clear();
+  m_fVRemoved.clear();
+  m_tm.clear();
 }
 
 template <typename T, typename U>
 void Mesh<T, U>::setGTable(VIndex index, const Point<U>& point) {
+  updateBoundingBox(&m_GTable[index], &point);
   m_GTable[index] = point;
+  invalidateDerivedData(DERIVED_NORMALS);
 }
 
 template <typename T, typename U>
 void Mesh<T, U>::setVTable(CIndex index, VIndex value) {
   m_VTable[index] = value;
+  touch();
 }
 
 template <typename T, typename U>
@@ -27,11 +30,13 @@ void Mesh<T, U>::setOpposites(CIndex index1, CIndex index2) {
     m_OTable[index1] = index2;
   if (index2 != -1)
     m_OTable[index2] = index1;
+  touch();
 }
 
 template <typename T, typename U>
 void Mesh<T, U>::setOTable(CIndex index, CIndex opposite) {
   m_OTable[index] = opposite;
+  touch();
 }
 
 template <typename T, typename U>
@@ -40,8 +45,18 @@ Mesh<T, U>::Mesh()
       m_fShowEdges(false),
       m_fShowCorners(false),
       m_fShowVertices(false),
+      m_numEdgeIndices(0),
+      m_featureEdgeAngle(0),
+      m_attributePrecision(AttributePrecision::FULL),
+      m_uploadedPrecision(AttributePrecision::FULL),
+      m_fStreamedGeometry(false),
+      m_fStagingRingFailed(false),
       m_fDrawPlane(false),
-      m_fShowNormals(true) {}
+      m_fShowNormals(true),
+      m_weldEpsilon(0),
+      m_fUseDerivedDataCache(false),
+      m_validDerivedData(0),
+      m_revision(0) {}
 
 template <typename T, typename U>
 Mesh<T, U>::Mesh(const Mesh& other)
@@ -52,13 +67,26 @@ Mesh<T, U>::Mesh(const Mesh& other)
       m_nv(other.m_nv),
       m_nt(other.m_nt),
       m_nc(other.m_nc),
+      m_featureEdgeAngle(other.m_featureEdgeAngle),
+      m_attributePrecision(other.m_attributePrecision),
+      m_uploadedPrecision(AttributePrecision::FULL),
+      m_fStreamedGeometry(false),
+      m_fStagingRingFailed(other.m_fStagingRingFailed),
       m_fShowEdges(other.m_fShowEdges),
       m_fShowCorners(other.m_fShowCorners),
       m_fShowVertices(other.m_fShowVertices),
       m_tm(other.m_tm),
       m_vm(other.m_vm),
       m_boxCenter(other.m_boxCenter),
-      m_fVRemoved(other.m_fVRemoved) {}
+      m_boundingBox(other.m_boundingBox),
+      m_boxFaceCounts(other.m_boxFaceCounts),
+      m_normals(other.m_normals),
+      m_fVRemoved(other.m_fVRemoved),
+      m_weldEpsilon(other.m_weldEpsilon),
+      m_fUseDerivedDataCache(other.m_fUseDerivedDataCache),
+      m_derivedDataCacheDirectory(other.m_derivedDataCacheDirectory),
+      m_validDerivedData(other.m_validDerivedData),
+      m_revision(0) {}
 
 template <typename T, typename U>
 Mesh<T, U>& Mesh<T, U>::swap(Mesh& other) {
@@ -70,9 +98,22 @@ Mesh<T, U>& Mesh<T, U>::swap(Mesh& other) {
   std::swap(m_nc, other.m_nc);
   std::swap(m_nt, other.m_nt);
   std::swap(m_tm, other.m_tm);
-  std::swap(m_vm, other.m_vn);
+  std::swap(m_vm, other.m_vm);
+  std::swap(m_fVRemoved, other.m_fVRemoved);
+  std::swap(m_normals, other.m_normals);
+  std::swap(m_pColorMap, other.m_pColorMap);
+  std::swap(m_validDerivedData, other.m_validDerivedData);
+  std::swap(m_revision, other.m_revision);
 
   std::swap(m_boxCenter, other.m_boxCenter);
+  std::swap(m_boundingBox, other.m_boundingBox);
+  std::swap(m_boxFaceCounts, other.m_boxFaceCounts);
+  std::swap(m_pStagingRing, other.m_pStagingRing);
+  std::swap(m_fStreamedGeometry, other.m_fStreamedGeometry);
+  std::swap(m_fStagingRingFailed, other.m_fStagingRingFailed);
+  std::swap(m_streamedVertexOffset, other.m_streamedVertexOffset);
+  std::swap(m_streamedNormalOffset, other.m_streamedNormalOffset);
+  std::swap(m_streamedEdgeOffset, other.m_streamedEdgeOffset);
   std::swap(m_fShowCorners, other.m_fShowCorners);
   std::swap(m_fShowEdges, other.m_fShowEdges);
   std::swap(m_fShowVertices, other.m_fShowVertices);
@@ -86,6 +127,7 @@ Mesh<T, U>& Mesh<T, U>::operator=(Mesh other) {
 
 template <typename T, typename U>
 Point<U> Mesh<T, U>::centerBoundingBox() const throw() {
+  ensureBoundingBox();
   return m_boxCenter;
 }
 
@@ -97,6 +139,7 @@ void Mesh<T, U>::init() {
 
 template <typename T, typename U>
 void Mesh<T, U>::resetMarkers() {
+  ensureMarkers();
   std::fill(m_vm.begin(), m_vm.end(), 0);
   std::fill(m_tm.begin(), m_tm.end(), 0);
   std::fill(m_fVRemoved.begin(), m_fVRemoved.end(), false);
@@ -210,6 +253,7 @@ typename Mesh<T, U>::CIndex Mesh<T, U>::selectedCorner() const throw() {
 
 template <typename T, typename U>
 void Mesh<T, U>::setSelectedCorner(CIndex cIndex) {
+  ensureMarkers();
   // Reset the color for the prev selected corner
   if (m_selectedCorner != -1) {
     m_tm[t(m_selectedCorner)] = m_selectedCornerPrevTM;
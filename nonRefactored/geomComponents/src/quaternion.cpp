@@ -0,0 +1,123 @@
+#include "precomp.h"
+#include "quaternion.h"
+
+Quaternion::Quaternion(const Vector<float>& axis, float angle)
+{
+  float s = sin(angle / 2);
+  m_w = cos(angle / 2);
+  m_x = axis.x() * s;
+  m_y = axis.y() * s;
+  m_z = axis.z() * s;
+}
+
+// Shepperd's method: take the square root of the largest of 4w^2, 4x^2, 4y^2 and 4z^2, which
+// are read off the diagonal, and the other components from the off diagonal sums and differences
+Quaternion Quaternion::fromMatrix(const Matrix& matrix)
+{
+  const float* gl = matrix.getAsGLArray();
+  auto m = [gl](int row, int column) { return gl[4 * column + row]; };
+
+  float trace = m(0, 0) + m(1, 1) + m(2, 2);
+  Quaternion result;
+  if (trace > m(0, 0) && trace > m(1, 1) && trace > m(2, 2))
+  {
+    float s = 2 * sqrt(1 + trace);
+    result = Quaternion(s / 4, (m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s, (m(1, 0) - m(0, 1)) / s);
+  }
+  else if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2))
+  {
+    float s = 2 * sqrt(1 + m(0, 0) - m(1, 1) - m(2, 2));
+    result = Quaternion((m(2, 1) - m(1, 2)) / s, s / 4, (m(0, 1) + m(1, 0)) / s, (m(0, 2) + m(2, 0)) / s);
+  }
+  else if (m(1, 1) > m(2, 2))
+  {
+    float s = 2 * sqrt(1 - m(0, 0) + m(1, 1) - m(2, 2));
+    result = Quaternion((m(0, 2) - m(2, 0)) / s, (m(0, 1) + m(1, 0)) / s, s / 4, (m(1, 2) + m(2, 1)) / s);
+  }
+  else
+  {
+    float s = 2 * sqrt(1 - m(0, 0) - m(1, 1) + m(2, 2));
+    result = Quaternion((m(1, 0) - m(0, 1)) / s, (m(0, 2) + m(2, 0)) / s, (m(1, 2) + m(2, 1)) / s, s / 4);
+  }
+  result.normalize();
+  return result;
+}
+
+Quaternion Quaternion::operator*(const Quaternion& other) const throw()
+{
+  return Quaternion(m_w * other.m_w - m_x * other.m_x - m_y * other.m_y - m_z * other.m_z,
+                    m_w * other.m_x + m_x * other.m_w + m_y * other.m_z - m_z * other.m_y,
+                    m_w * other.m_y - m_x * other.m_z + m_y * other.m_w + m_z * other.m_x,
+                    m_w * other.m_z + m_x * other.m_y - m_y * other.m_x + m_z * other.m_w);
+}
+
+float Quaternion::dot(const Quaternion& other) const throw()
+{
+  return m_w * other.m_w + m_x * other.m_x + m_y * other.m_y + m_z * other.m_z;
+}
+
+void Quaternion::normalize() throw()
+{
+  float length = sqrt(dot(*this));
+  if (length == 0)
+  {
+    *this = Quaternion();
+    return;
+  }
+  m_w /= length;
+  m_x /= length;
+  m_y /= length;
+  m_z /= length;
+}
+
+// v + 2w (q x v) + 2 q x (q x v) for the vector part q
+Vector<float> Quaternion::rotate(const Vector<float>& vector) const throw()
+{
+  float cx = 2 * (m_y * vector.z() - m_z * vector.y());
+  float cy = 2 * (m_z * vector.x() - m_x * vector.z());
+  float cz = 2 * (m_x * vector.y() - m_y * vector.x());
+  return Vector<float>(vector.x() + m_w * cx + m_y * cz - m_z * cy,
+                       vector.y() + m_w * cy + m_z * cx - m_x * cz,
+                       vector.z() + m_w * cz + m_x * cy - m_y * cx);
+}
+
+Matrix Quaternion::toMatrix(const Vector<float>& translation) const throw()
+{
+  float xx = m_x * m_x, yy = m_y * m_y, zz = m_z * m_z;
+  float xy = m_x * m_y, xz = m_x * m_z, yz = m_y * m_z;
+  float wx = m_w * m_x, wy = m_w * m_y, wz = m_w * m_z;
+  float matrix[4][4] = { 1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy), translation.x(),
+    2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx), translation.y(),
+    2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy), translation.z(),
+    0, 0, 0, 1 };
+  return Matrix(matrix, Matrix::Kind::RIGID);
+}
+
+Quaternion Quaternion::slerp(const Quaternion& from, const Quaternion& to, float t) throw()
+{
+  // q and -q are the same rotation; pick the sign giving the shorter arc
+  float cosAngle = from.dot(to);
+  float sign = 1;
+  if (cosAngle < 0)
+  {
+    cosAngle = -cosAngle;
+    sign = -1;
+  }
+
+  // Nearly parallel rotations are interpolated linearly, where sin(angle) would lose precision
+  float fromWeight = 1 - t;
+  float toWeight = t;
+  if (cosAngle < 0.9995f)
+  {
+    float angle = acos(cosAngle);
+    float sinAngle = sin(angle);
+    fromWeight = sin((1 - t) * angle) / sinAngle;
+    toWeight = sin(t * angle) / sinAngle;
+  }
+  toWeight *= sign;
+
+  Quaternion result(fromWeight * from.m_w + toWeight * to.m_w, fromWeight * from.m_x + toWeight * to.m_x,
+                    fromWeight * from.m_y + toWeight * to.m_y, fromWeight * from.m_z + toWeight * to.m_z);
+  result.normalize();
+  return result;
+}
@@ -0,0 +1,85 @@
+#include "precomp.h"
+#include "glStagingBackend.h"
+
+namespace
+{
+const GLuint64 c_fenceTimeoutNanoseconds = 1000000000;  // 1s per wait attempt
+
+GLsync toSync(IStagingBackend::FenceHandle fence)
+{
+  return reinterpret_cast<GLsync>(static_cast<uintptr_t>(fence));
+}
+}
+
+GlStagingBackend::GlStagingBackend() : m_buffer(0)
+{
+}
+
+GlStagingBackend::~GlStagingBackend()
+{
+  release();
+}
+
+bool GlStagingBackend::isSupported()
+{
+  return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+unsigned char* GlStagingBackend::allocate(size_t size)
+{
+  release();
+  const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+  glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+  void* pMapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  if (pMapping == nullptr)
+  {
+    LOG("Failed to map staging buffer of " << size << " bytes", DEBUG_LEVELS::HIGH);
+  }
+  return static_cast<unsigned char*>(pMapping);
+}
+
+void GlStagingBackend::release()
+{
+  if (m_buffer != 0)
+  {
+    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+  }
+}
+
+IStagingBackend::FenceHandle GlStagingBackend::insertFence()
+{
+  return static_cast<FenceHandle>(reinterpret_cast<uintptr_t>(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)));
+}
+
+bool GlStagingBackend::isFenceSignalled(FenceHandle fence)
+{
+  GLenum result = glClientWaitSync(toSync(fence), 0, 0);
+  return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void GlStagingBackend::waitFence(FenceHandle fence)
+{
+  // Flush on the first attempt so the fence is guaranteed to be submitted
+  GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+  while (true)
+  {
+    GLenum result = glClientWaitSync(toSync(fence), flags, c_fenceTimeoutNanoseconds);
+    if (result != GL_TIMEOUT_EXPIRED)
+    {
+      return;  // Signalled, or GL_WAIT_FAILED which retrying will not fix
+    }
+    flags = 0;
+  }
+}
+
+void GlStagingBackend::deleteFence(FenceHandle fence)
+{
+  glDeleteSync(toSync(fence));
+}
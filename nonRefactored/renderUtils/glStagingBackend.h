@@ -0,0 +1,29 @@
+#ifndef _GL_STAGING_BACKEND_H_
+#define _GL_STAGING_BACKEND_H_
+
+#include <GL/glew.h>
+
+#include "stagingRing.h"
+
+// Persistently mapped buffer (ARB_buffer_storage) with GL sync objects
+class GlStagingBackend : public IStagingBackend {
+ public:
+  GlStagingBackend();
+  ~GlStagingBackend();
+
+  // Persistent mapping needs GL 4.4 or ARB_buffer_storage
+  static bool isSupported();
+
+  unsigned char* allocate(size_t size) override;
+  void release() override;
+  unsigned int bufferName() const override { return m_buffer; }
+  FenceHandle insertFence() override;
+  bool isFenceSignalled(FenceHandle fence) override;
+  void waitFence(FenceHandle fence) override;
+  void deleteFence(FenceHandle fence) override;
+
+ private:
+  GLuint m_buffer;
+};
+
+#endif  //_GL_STAGING_BACKEND_H_
@@ -0,0 +1,415 @@
+#include "precomp.h"
+#include "meshLodCache.h"
+#include "mesh.h"
+#include <cmath>
+#include <unordered_map>
+
+namespace
+{
+// Level 1 is used below this many pixels, and each further level halves it
+const float c_fullDetailPixels = 512.0f;
+const float c_lodHysteresis = 0.2f;
+// Grid cells along the longest side of the bounding box for level 1
+const int c_finestGridResolution = 128;
+// Vertices or triangles between checks of the cancel flag
+const size_t c_cancelCheckInterval = 1 << 14;
+
+bool isCancelled(const std::atomic<bool>* pfCancel, size_t i)
+{
+  return pfCancel != nullptr && i % c_cancelCheckInterval == 0 && *pfCancel;
+}
+
+float levelThreshold(int level)
+{
+  return c_fullDetailPixels / float(1 << (level - 1));
+}
+
+void computeNormals(LodLevelData& level)
+{
+  std::vector<float>& vertices = level.vertices;
+  for (size_t i = 0; i + 2 < level.indices.size(); i += 3)
+  {
+    const float* p0 = &vertices[6 * level.indices[i]];
+    const float* p1 = &vertices[6 * level.indices[i + 1]];
+    const float* p2 = &vertices[6 * level.indices[i + 2]];
+    float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    // Area weighted face normal
+    float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                        e1[0] * e2[1] - e1[1] * e2[0] };
+    for (int corner = 0; corner < 3; corner++)
+    {
+      float* n = &vertices[6 * level.indices[i + corner] + 3];
+      n[0] += normal[0];
+      n[1] += normal[1];
+      n[2] += normal[2];
+    }
+  }
+  for (size_t v = 0; v < vertices.size(); v += 6)
+  {
+    float* n = &vertices[v + 3];
+    float norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    if (norm > 0)
+    {
+      n[0] /= norm;
+      n[1] /= norm;
+      n[2] /= norm;
+    }
+  }
+}
+}
+
+LodLevelData simplifyByVertexClustering(const std::vector<float>& positions, const std::vector<unsigned int>& indices,
+                                        const std::vector<uint8_t>& triangleColors, int gridResolution,
+                                        const std::atomic<bool>* pfCancel)
+{
+  LodLevelData level;
+  size_t numVertices = positions.size() / 3;
+  if (numVertices == 0)
+  {
+    return level;
+  }
+
+  float low[3] = { positions[0], positions[1], positions[2] };
+  float high[3] = { positions[0], positions[1], positions[2] };
+  for (size_t v = 0; v < numVertices; v++)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      low[axis] = std::min(low[axis], positions[3 * v + axis]);
+      high[axis] = std::max(high[axis], positions[3 * v + axis]);
+    }
+  }
+  float extent = std::max(std::max(high[0] - low[0], high[1] - low[1]), high[2] - low[2]);
+  float cellSize = extent > 0 ? extent / gridResolution : 1.0f;
+
+  // Map each vertex to the cluster of its grid cell; cluster positions are the
+  // mean of their members
+  std::unordered_map<uint64_t, unsigned int> cellToCluster;
+  std::vector<unsigned int> vertexToCluster(numVertices);
+  std::vector<unsigned int> clusterSize;
+  for (size_t v = 0; v < numVertices; v++)
+  {
+    if (isCancelled(pfCancel, v))
+    {
+      return LodLevelData();
+    }
+    uint64_t key = 0;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      uint64_t cell = uint64_t((positions[3 * v + axis] - low[axis]) / cellSize);
+      key = (key << 21) | std::min<uint64_t>(cell, (1 << 21) - 1);
+    }
+    auto inserted = cellToCluster.insert(std::make_pair(key, (unsigned int)clusterSize.size()));
+    unsigned int cluster = inserted.first->second;
+    if (inserted.second)
+    {
+      clusterSize.push_back(0);
+      level.vertices.insert(level.vertices.end(), 6, 0.0f);
+    }
+    vertexToCluster[v] = cluster;
+    clusterSize[cluster]++;
+    for (int axis = 0; axis < 3; axis++)
+    {
+      level.vertices[6 * cluster + axis] += positions[3 * v + axis];
+    }
+  }
+  for (size_t cluster = 0; cluster < clusterSize.size(); cluster++)
+  {
+    for (int axis = 0; axis < 3; axis++)
+    {
+      level.vertices[6 * cluster + axis] /= clusterSize[cluster];
+    }
+  }
+
+  // Keep triangles whose corners landed in three different clusters
+  std::vector<size_t> sourceTriangles;
+  level.indices.reserve(indices.size() / 4);
+  for (size_t i = 0; i + 2 < indices.size(); i += 3)
+  {
+    if (isCancelled(pfCancel, i / 3))
+    {
+      return LodLevelData();
+    }
+    unsigned int a = vertexToCluster[indices[i]];
+    unsigned int b = vertexToCluster[indices[i + 1]];
+    unsigned int c = vertexToCluster[indices[i + 2]];
+    if (a != b && b != c && a != c)
+    {
+      level.indices.push_back(a);
+      level.indices.push_back(b);
+      level.indices.push_back(c);
+      sourceTriangles.push_back(i / 3);
+    }
+  }
+
+  computeNormals(level);
+
+  // Normals are smooth across clusters, but colours are per triangle, so a
+  // cluster gets one vertex per distinct colour of the triangles around it
+  LodLevelData coloredLevel;
+  std::unordered_map<uint64_t, unsigned int> clusterColorToVertex;
+  coloredLevel.indices.reserve(level.indices.size());
+  for (size_t i = 0; i < level.indices.size(); i++)
+  {
+    const uint8_t* color = &triangleColors[4 * sourceTriangles[i / 3]];
+    uint32_t rgba = uint32_t(color[0]) << 24 | uint32_t(color[1]) << 16 | uint32_t(color[2]) << 8 | color[3];
+    unsigned int cluster = level.indices[i];
+    auto inserted = clusterColorToVertex.insert(
+        std::make_pair(uint64_t(cluster) << 32 | rgba, (unsigned int)(coloredLevel.vertices.size() / 6)));
+    if (inserted.second)
+    {
+      coloredLevel.vertices.insert(coloredLevel.vertices.end(), &level.vertices[6 * cluster],
+                                   &level.vertices[6 * cluster] + 6);
+      coloredLevel.colors.insert(coloredLevel.colors.end(), color, color + 4);
+    }
+    coloredLevel.indices.push_back(inserted.first->second);
+  }
+  return coloredLevel;
+}
+
+MeshLodCache::MeshLodCache(IInteractableMesh& mesh) : m_numStableDraws(0), m_fCancelBuild(false)
+{
+  startBuild(mesh);
+}
+
+MeshLodCache::~MeshLodCache()
+{
+  stopBuild();
+  releaseGpuLevels();
+}
+
+void MeshLodCache::update(IInteractableMesh& mesh)
+{
+  unsigned int revision = mesh.revision();
+  if (revision == m_builtRevision)
+  {
+    return;
+  }
+  if (revision != m_seenRevision)
+  {
+    m_seenRevision = revision;
+    m_numStableDraws = 0;
+    return;
+  }
+  if (++m_numStableDraws < c_stableDrawsBeforeRebuild)
+  {
+    return;
+  }
+  stopBuild();
+  releaseGpuLevels();
+  startBuild(mesh);
+}
+
+void MeshLodCache::startBuild(IInteractableMesh& mesh)
+{
+  std::vector<float> positions;
+  std::vector<unsigned int> indices;
+  std::vector<uint8_t> triangleColors;
+  mesh.exportFlatGeometry(positions, indices, triangleColors);
+  // Exporting may materialize markers, so take the revision afterwards
+  m_builtRevision = mesh.revision();
+  m_seenRevision = m_builtRevision;
+
+  m_gpuLevels.assign(c_numSimplifiedLevels, GpuLevel());
+  m_fResident.assign(c_numSimplifiedLevels, false);
+  m_fCancelBuild = false;
+
+  // Coarsest first, so that small meshes get a cheap level as soon as possible
+  m_buildThread = std::thread([this](std::vector<float> positions, std::vector<unsigned int> indices,
+                                     std::vector<uint8_t> triangleColors) {
+    for (int level = c_numSimplifiedLevels; level >= 1 && !m_fCancelBuild; level--)
+    {
+      LodLevelData data = simplifyByVertexClustering(positions, indices, triangleColors,
+                                                     c_finestGridResolution >> (level - 1), &m_fCancelBuild);
+      if (m_fCancelBuild)
+      {
+        break;
+      }
+      std::lock_guard<std::mutex> lock(m_pendingMutex);
+      m_pendingLevels.emplace_back(level, std::move(data));
+    }
+  }, std::move(positions), std::move(indices), std::move(triangleColors));
+}
+
+void MeshLodCache::stopBuild()
+{
+  m_fCancelBuild = true;
+  if (m_buildThread.joinable())
+  {
+    m_buildThread.join();
+  }
+  std::lock_guard<std::mutex> lock(m_pendingMutex);
+  m_pendingLevels.clear();
+}
+
+void MeshLodCache::releaseGpuLevels()
+{
+  for (size_t i = 0; i < m_gpuLevels.size(); i++)
+  {
+    if (m_fResident[i])
+    {
+      glDeleteBuffers(1, &m_gpuLevels[i].vertexBuffer);
+      glDeleteBuffers(1, &m_gpuLevels[i].colorBuffer);
+      glDeleteBuffers(1, &m_gpuLevels[i].indexBuffer);
+    }
+  }
+  m_fResident.assign(m_fResident.size(), false);
+}
+
+bool MeshLodCache::isLevelResident(int level) const throw()
+{
+  return level == 0 || (level > 0 && level < numLevels() && m_fResident[level - 1]);
+}
+
+int MeshLodCache::selectLevel(float projectedSize, int currentLevel) const throw()
+{
+  int level = clamp(currentLevel, 0, numLevels() - 1);
+  while (level + 1 < numLevels() && projectedSize < levelThreshold(level + 1) * (1.0f - c_lodHysteresis))
+  {
+    level++;
+  }
+  while (level > 0 && projectedSize > levelThreshold(level) * (1.0f + c_lodHysteresis))
+  {
+    level--;
+  }
+  return level;
+}
+
+void MeshLodCache::uploadPendingLevels()
+{
+  std::vector<std::pair<int, LodLevelData>> readyLevels;
+  {
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    readyLevels.swap(m_pendingLevels);
+  }
+
+  for (auto& readyLevel : readyLevels)
+  {
+    GpuLevel& gpuLevel = m_gpuLevels[readyLevel.first - 1];
+    const LodLevelData& data = readyLevel.second;
+    glGenBuffers(1, &gpuLevel.vertexBuffer);
+    glGenBuffers(1, &gpuLevel.colorBuffer);
+    glGenBuffers(1, &gpuLevel.indexBuffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, gpuLevel.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * data.vertices.size(), data.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, gpuLevel.colorBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(uint8_t) * data.colors.size(), data.colors.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuLevel.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * data.indices.size(), data.indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    gpuLevel.numIndices = GLsizei(data.indices.size());
+    m_fResident[readyLevel.first - 1] = true;
+  }
+}
+
+void MeshLodCache::drawLevel(int level) const
+{
+  assert(level > 0 && isLevelResident(level));
+  const GpuLevel& gpuLevel = m_gpuLevels[level - 1];
+
+  glEnable(GL_CULL_FACE);
+  glCullFace(GL_BACK);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glEnable(GL_COLOR_MATERIAL);
+
+  glBindBuffer(GL_ARRAY_BUFFER, gpuLevel.vertexBuffer);
+  glVertexPointer(3, GL_FLOAT, 6 * sizeof(float), 0);
+  glNormalPointer(GL_FLOAT, 6 * sizeof(float), reinterpret_cast<const GLvoid*>(3 * sizeof(float)));
+  glBindBuffer(GL_ARRAY_BUFFER, gpuLevel.colorBuffer);
+  glColorPointer(4, GL_UNSIGNED_BYTE, 0, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpuLevel.indexBuffer);
+
+  glDrawElements(GL_TRIANGLES, gpuLevel.numIndices, GL_UNSIGNED_INT, 0);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisable(GL_CULL_FACE);
+}
+
+// Largest side, in pixels, of the screen rectangle covering the projected
+// bounding box under the current GL matrices
+float LodMeshDrawable::projectedBoundingBoxSize() const
+{
+  GLint viewport[4];
+  GLfloat modelView[16];
+  GLfloat projection[16];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+  glGetFloatv(GL_PROJECTION_MATRIX, projection);
+
+  Point<float> center = m_pMesh->boundingBoxCenter();
+  Point<float> size = m_pMesh->boundingBoxSize();
+  float low[2] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+  float high[2] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+
+  for (int cornerIndex = 0; cornerIndex < 8; cornerIndex++)
+  {
+    float corner[4] = { center.x() + ((cornerIndex & 1) ? 0.5f : -0.5f) * size.x(),
+                        center.y() + ((cornerIndex & 2) ? 0.5f : -0.5f) * size.y(),
+                        center.z() + ((cornerIndex & 4) ? 0.5f : -0.5f) * size.z(), 1.0f };
+    float eye[4];
+    float clip[4];
+    // GL matrices are column major
+    for (int i = 0; i < 4; i++)
+    {
+      eye[i] = modelView[i] * corner[0] + modelView[4 + i] * corner[1] + modelView[8 + i] * corner[2] +
+               modelView[12 + i] * corner[3];
+    }
+    for (int i = 0; i < 4; i++)
+    {
+      clip[i] = projection[i] * eye[0] + projection[4 + i] * eye[1] + projection[8 + i] * eye[2] +
+                projection[12 + i] * eye[3];
+    }
+    if (clip[3] <= 0)
+    {
+      // Part of the box is behind the eye; treat it as filling the viewport
+      return std::numeric_limits<float>::max();
+    }
+    for (int axis = 0; axis < 2; axis++)
+    {
+      float pixel = (clip[axis] / clip[3] * 0.5f + 0.5f) * viewport[2 + axis];
+      low[axis] = std::min(low[axis], pixel);
+      high[axis] = std::max(high[axis], pixel);
+    }
+  }
+  return std::max(high[0] - low[0], high[1] - low[1]);
+}
+
+void LodMeshDrawable::draw()
+{
+  m_pLodCache->update(*m_pMesh);
+  if (!m_pLodCache->isCurrent(*m_pMesh))
+  {
+    // Levels of the old geometry; draw the live mesh until the rebuild
+    m_pMesh->draw();
+    return;
+  }
+  m_pLodCache->uploadPendingLevels();
+  m_currentLevel = m_pLodCache->selectLevel(projectedBoundingBoxSize(), m_currentLevel);
+
+  // Until the chosen level is uploaded, draw the closest finer one
+  int level = m_currentLevel;
+  while (level > 0 && !m_pLodCache->isLevelResident(level))
+  {
+    level--;
+  }
+
+  if (level == 0)
+  {
+    m_pMesh->draw();
+  }
+  else
+  {
+    m_pLodCache->drawLevel(level);
+  }
+}
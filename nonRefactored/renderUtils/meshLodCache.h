@@ -0,0 +1,124 @@
+#ifndef _MESH_LOD_CACHE_H_
+#define _MESH_LOD_CACHE_H_
+
+#include <GL/glew.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "drawable.h"
+
+class IInteractableMesh;
+
+// Geometry for one level of detail, as flat interleaved position / normal
+// floats, RGBA colours and triangle indices
+struct LodLevelData {
+  std::vector<float> vertices;  // x y z nx ny nz per vertex
+  std::vector<uint8_t> colors;  // r g b a per vertex
+  std::vector<unsigned int> indices;
+};
+
+// A pyramid of simplified versions of one mesh. Level 0 is the mesh itself;
+// levels 1..numLevels() - 1 are built by vertex clustering on successively
+// coarser grids on a background thread. Once a level is ready its vertex and
+// index buffers are uploaded on the next draw and stay resident, so every
+// viewport showing the mesh shares them. Levels keep the marker colours of the
+// triangles they were simplified from.
+class MeshLodCache {
+ public:
+  static const int c_numSimplifiedLevels = 4;
+  static const int c_stableDrawsBeforeRebuild = 16;
+
+  explicit MeshLodCache(IInteractableMesh& mesh);
+  ~MeshLodCache();
+
+  // Called once per draw. Once mesh has changed since the pyramid was built
+  // and then held still for c_stableDrawsBeforeRebuild draws, throw the
+  // pyramid away and rebuild it. A mesh that changes every frame, such as
+  // deforming playback, is not rebuilt until it stops
+  void update(IInteractableMesh& mesh);
+
+  // True if the levels were built from the current geometry of mesh; stale
+  // levels must not be drawn
+  bool isCurrent(const IInteractableMesh& mesh) const throw() {
+    return mesh.revision() == m_builtRevision;
+  }
+
+  int numLevels() const throw() { return c_numSimplifiedLevels + 1; }
+
+  // True once level has been uploaded. Level 0 is always available since it
+  // is drawn by the mesh itself
+  bool isLevelResident(int level) const throw();
+
+  // Pick a level for a mesh that covers projectedSize pixels on screen, given
+  // the level it was drawn with last frame. Each level halves the pixel size at
+  // which it is used; switching needs the size to move past the threshold by a
+  // hysteresis margin so meshes near a threshold do not flicker between levels.
+  int selectLevel(float projectedSize, int currentLevel) const throw();
+
+  // Upload any levels finished by the background build. Needs a GL context
+  void uploadPendingLevels();
+
+  // Draw a simplified level with its resident buffers
+  void drawLevel(int level) const;
+
+ private:
+  struct GpuLevel {
+    GLuint vertexBuffer;
+    GLuint colorBuffer;
+    GLuint indexBuffer;
+    GLsizei numIndices;
+  };
+
+  void startBuild(IInteractableMesh& mesh);
+  void stopBuild();
+  void releaseGpuLevels();
+
+  unsigned int m_builtRevision;  // Revision of the mesh the levels come from
+  unsigned int m_seenRevision;   // Revision seen by the last update
+  int m_numStableDraws;          // Draws since m_seenRevision last changed
+  std::thread m_buildThread;
+  std::atomic<bool> m_fCancelBuild;
+
+  mutable std::mutex m_pendingMutex;
+  std::vector<std::pair<int, LodLevelData>> m_pendingLevels;
+
+  std::vector<GpuLevel> m_gpuLevels;  // Index i holds level i + 1
+  std::vector<bool> m_fResident;
+};
+
+// Build one simplified level by clustering vertices of the given mesh into a
+// uniform grid with gridResolution cells along the longest bounding box side.
+// Each kept triangle takes the colour of the triangle it came from. Returns an
+// empty level early once *pfCancel is set
+LodLevelData simplifyByVertexClustering(
+    const std::vector<float>& positions,
+    const std::vector<unsigned int>& indices,
+    const std::vector<uint8_t>& triangleColors, int gridResolution,
+    const std::atomic<bool>* pfCancel = nullptr);
+
+// Draws a registered mesh at the level chosen for its current on-screen size.
+// One of these exists per viewport the mesh is registered in, so each viewport
+// keeps its own level and hysteresis state while sharing the cached buffers.
+class LodMeshDrawable : public IDrawable {
+ public:
+  LodMeshDrawable(IInteractableMesh* pMesh,
+                  std::shared_ptr<MeshLodCache> pLodCache)
+      : m_pMesh(pMesh), m_pLodCache(pLodCache), m_currentLevel(0) {}
+
+  void draw() override;
+  IInteractableMesh* mesh() const throw() { return m_pMesh; }
+  int currentLevel() const throw() { return m_currentLevel; }
+
+ private:
+  float projectedBoundingBoxSize() const;
+
+  IInteractableMesh* m_pMesh;
+  std::shared_ptr<MeshLodCache> m_pLodCache;
+  int m_currentLevel;
+};
+
+#endif  //_MESH_LOD_CACHE_H_
@@ -59,21 +59,88 @@ int ISceneNode::onMouseDragged(int deltaX, int deltaY, const IKeyboardState& key
   return retVal;
 }
 
-TransformationNode::TransformationNode()
+TransformationNode::TransformationNode() : m_translation(0, 0, 0), m_fHasBaseMatrix(false), m_fMatrixValid(false)
 {
-  m_matrix.setIdentity();
 }
 
-TransformationNode::TransformationNode( const Matrix& matrix )
+TransformationNode::TransformationNode( const Matrix& matrix ) : m_translation(0, 0, 0), m_fHasBaseMatrix(false), m_fMatrixValid(false)
 {
-  m_matrix = matrix;
+  setTransform(matrix);
 }
 
-Matrix TransformationNode::getLocalTransformationMatrix()
+const Matrix& TransformationNode::matrix()
 {
+  if (!m_fMatrixValid)
+  {
+    m_matrix = m_rotation.toMatrix(m_translation);
+    if (m_fHasBaseMatrix)
+    {
+      m_matrix = m_matrix * m_baseMatrix;
+    }
+    m_fMatrixValid = true;
+  }
   return m_matrix;
 }
 
+const float* TransformationNode::getTransformationAsGLArray()
+{
+  return matrix().getAsGLArray();
+}
+
+Matrix TransformationNode::getLocalTransformationMatrix()
+{
+  return matrix();
+}
+
+// As Matrix::rotate, the rotation is applied after the current transform, so it turns the translation too
+void TransformationNode::rotate(const Vector<float>& axis, float angle)
+{
+  Quaternion rotation(axis, angle);
+  m_rotation = rotation * m_rotation;
+  m_rotation.normalize();
+  m_translation = rotation.rotate(m_translation);
+  m_fMatrixValid = false;
+}
+
+void TransformationNode::translate(const Vector<float>& translation)
+{
+  m_translation = Vector<float>(m_translation.x() + translation.x(), m_translation.y() + translation.y(), m_translation.z() + translation.z());
+  m_fMatrixValid = false;
+}
+
+void TransformationNode::setTransform(const Matrix& matrix)
+{
+  if (matrix.kind() == Matrix::Kind::RIGID)
+  {
+    const float* gl = matrix.getAsGLArray();
+    setTransform(Quaternion::fromMatrix(matrix), Vector<float>(gl[12], gl[13], gl[14]));
+  }
+  else
+  {
+    setTransform(Quaternion(), Vector<float>(0, 0, 0));
+    m_baseMatrix = matrix;
+    m_fHasBaseMatrix = true;
+  }
+}
+
+void TransformationNode::setTransform(const Quaternion& rotation, const Vector<float>& translation)
+{
+  m_rotation = rotation;
+  m_translation = translation;
+  m_fHasBaseMatrix = false;
+  m_fMatrixValid = false;
+}
+
+void TransformationNode::interpolate(const TransformationNode& from, const TransformationNode& to, float t)
+{
+  const Vector<float>& a = from.m_translation;
+  const Vector<float>& b = to.m_translation;
+  setTransform(Quaternion::slerp(from.m_rotation, to.m_rotation, t),
+               Vector<float>(a.x() + t * (b.x() - a.x()), a.y() + t * (b.y() - a.y()), a.z() + t * (b.z() - a.z())));
+  m_baseMatrix = from.m_baseMatrix;
+  m_fHasBaseMatrix = from.m_fHasBaseMatrix;
+}
+
 void TransformationNode::accept(ISceneNodeVisitor* pVisitor)
 {
   pVisitor->visitBegin(this);
@@ -83,7 +150,7 @@ void TransformationNode::accept(ISceneNodeVisitor* pVisitor)
 
 int InteractableTransformationNode::onMouseDragged(int deltaX, int deltaY, const IKeyboardState& keyboardState)
 {
-  m_matrix.rotate(m_axis, -(PI * float(deltaX)) / k_MouseSensitivityMagicNum);
+  rotate(m_axis, -(PI * float(deltaX)) / k_MouseSensitivityMagicNum);
   return 1;
 }
 
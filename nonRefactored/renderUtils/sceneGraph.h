@@ -2,6 +2,7 @@
 #define _SCENEGRAPH_H_
 
 #include "matrix.h"
+#include "quaternion.h"
 #include "drawable.h"
 
 class ISceneNodeVisitor;
@@ -53,26 +54,43 @@ class ISceneNode : public IInteractable {
   ISceneNode* m_pParent;
 };
 
+// Holds its transform as a rotation and a translation applied after it, which
+// compose cheaply and stay rigid under repeated rotation. The Matrix is only
+// built when a GL array or local matrix is asked for. A transform that is not
+// rigid is kept as a base matrix applied before the rotation.
 class TransformationNode : public ISceneNode {
  public:
   TransformationNode();
   TransformationNode(const Matrix& matrix);
 
-  const float* getTransformationAsGLArray() { return m_matrix.getAsGLArray(); }
+  const float* getTransformationAsGLArray();
   Matrix getLocalTransformationMatrix() override;
 
   void accept(ISceneNodeVisitor* pVisitor) override;
 
-  void rotate(const Vector<float>& axis, float angle) {
-    m_matrix.rotate(axis, angle);
-  }
-  void translate(const Vector<float>& translation) {
-    m_matrix.translate(translation);
-  }
-  void setTransform(const Matrix& matrix) { m_matrix = matrix; }
+  void rotate(const Vector<float>& axis, float angle);
+  void translate(const Vector<float>& translation);
+  void setTransform(const Matrix& matrix);
+  void setTransform(const Quaternion& rotation,
+                    const Vector<float>& translation);
+  // Slerp of the rotations and lerp of the translations of from and to, for
+  // animation; the base matrix is taken from from
+  void interpolate(const TransformationNode& from,
+                   const TransformationNode& to, float t);
+
+  const Quaternion& rotation() const throw() { return m_rotation; }
+  const Vector<float>& translation() const throw() { return m_translation; }
+
+ private:
+  const Matrix& matrix();
+
+  Quaternion m_rotation;
+  Vector<float> m_translation;
+  Matrix m_baseMatrix;
+  bool m_fHasBaseMatrix;
 
- protected:
   Matrix m_matrix;
+  bool m_fMatrixValid;
 };
 
 class InteractableTransformationNode : public TransformationNode {
@@ -22,11 +22,24 @@ IInteractableMesh* Viewport::getSelectedMesh() throw()
 void Viewport::unregisterMesh( IInteractableMesh* pMesh ) throw()
 {
   m_pMeshes.erase( std::remove( m_pMeshes.begin(), m_pMeshes.end(), pMesh ), m_pMeshes.end() );
+  auto lodNodeIter = m_lodMeshNodes.find( pMesh );
+  if ( lodNodeIter != m_lodMeshNodes.end() )
+  {
+    removeSceneNode( lodNodeIter->second );
+    m_lodMeshNodes.erase( lodNodeIter );
+  }
 }
 
-void Viewport::registerMesh(IInteractableMesh* pMesh, const Matrix& worldTransformationMatrix) throw()
+void Viewport::registerMesh(IInteractableMesh* pMesh, const Matrix& worldTransformationMatrix, std::shared_ptr<MeshLodCache> pLodCache) throw()
 {
   m_pMeshes.push_back( pMesh );
+  if ( pLodCache )
+  {
+    std::unique_ptr<IDrawable> pLodDrawable( new LodMeshDrawable( pMesh, pLodCache ) );
+    std::unique_ptr<TransformationNode> pTransformationNode( new TransformationNode( worldTransformationMatrix ) );
+    pTransformationNode->addChild( std::unique_ptr<GeometryNode>( new GeometryNode( std::move( pLodDrawable ) ) ) );
+    m_lodMeshNodes[pMesh] = addSceneNode( std::move( pTransformationNode ) );
+  }
   m_pCameraNode->setLookAt(pMesh->boundingBoxCenter());
   m_pCameraNode->setEye(Point<float>(pMesh->boundingBoxCenter().x(), pMesh->boundingBoxCenter().y(), pMesh->boundingBoxCenter().z() + pMesh->boundingBoxSize().z()));
   m_pCameraNode->setUp(Vector<float>(0, 1, 0));
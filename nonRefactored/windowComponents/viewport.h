@@ -5,18 +5,17 @@
 #include "viewInterface.h"
 #include "SceneGraph.h"
 #include "Mesh.h"
+#include "meshLodCache.h"
 
 class Viewport : public IViewport
 {
 public:
+  // Takes over the scene graph, so LOD drawables keep their transforms
   Viewport( Viewport&& other ) : m_rect( other.m_rect ), m_pMeshes( std::move( other.m_pMeshes ) ) , m_pViewportHost( nullptr ), 
-                                 m_selectedMeshIndex(-1), m_fLighting( true ), m_listener( other.m_listener ) 
+                                 m_selectedMeshIndex(-1), m_fLighting( true ), m_listener( other.m_listener ),
+                                 m_pSceneGraphRoot( std::move( other.m_pSceneGraphRoot ) ), m_pCameraNode( other.m_pCameraNode ),
+                                 m_lodMeshNodes( std::move( other.m_lodMeshNodes ) )
   {
-    m_pSceneGraphRoot.reset(new TransformationNode());
-    std::for_each( m_pMeshes.begin(), m_pMeshes.end(), [ this ] ( IInteractableMesh* pMesh ) {
-      std::unique_ptr<GeometryNode> pGeometryNode(new GeometryNode(pMesh));
-      m_pSceneGraphRoot->addChild(std::move(pGeometryNode));
-    } );
   }
 
   Viewport( const Rect<int>& rect, INotifiable& listenter );
@@ -37,7 +36,12 @@ public:
   }
   void removeSceneNode(ISceneNode* pSceneNode) throw() { m_pSceneGraphRoot->removeChild(pSceneNode); }
 
-  void registerMesh(IInteractableMesh* pMesh, const Matrix& worldTransformationMatrix);
+  // With a LOD cache, the viewport adds the mesh to the scene itself, under
+  // worldTransformationMatrix, drawn at a level picked from its size in this
+  // viewport. Callers then must not add their own node for the mesh. Without
+  // one, drawing the mesh is left to the caller as before
+  void registerMesh(IInteractableMesh* pMesh, const Matrix& worldTransformationMatrix,
+                    std::shared_ptr<MeshLodCache> pLodCache = nullptr);
   void unregisterMesh(IInteractableMesh* pMesh);
 
   void draw() override;
@@ -81,6 +85,7 @@ protected:
 
   std::unique_ptr<ISceneNode> m_pSceneGraphRoot;
   CameraNode* m_pCameraNode;
+  std::map< IInteractableMesh*, ISceneNode* > m_lodMeshNodes;  // Transform node of each mesh drawn with LOD
 };
 
 #endif//_VIEWPORT_H_
\ No newline at end of file
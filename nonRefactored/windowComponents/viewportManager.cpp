@@ -4,7 +4,8 @@
 const int c_viewPortWidth = 1600 / 3;
 
 ViewportManager::ViewportManager( const Rect<int>& rect ) : m_selectedViewport( -1 ), m_fShowingFullScreen( false ),
-                                                            m_rect( rect ), m_previousMousePosition( -1, -1, 0 ), m_fKeyEntryMode( false )
+                                                            m_rect( rect ), m_previousMousePosition( -1, -1, 0 ), m_fKeyEntryMode( false ),
+                                                            m_fUseLod( false )
 {
   createViewportHost( m_pViewportHost, this );
 }
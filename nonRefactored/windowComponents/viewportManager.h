@@ -22,6 +22,25 @@ private:
   bool m_fKeyEntryMode;
   std::string m_command;
 
+  //Simplified versions of registered meshes, shared by all viewports
+  bool m_fUseLod;
+  std::map< const IInteractableMesh*, std::shared_ptr< MeshLodCache > > m_lodCaches;
+
+  template< class T, class U > std::shared_ptr< MeshLodCache > getLodCache( Mesh<T, U>* pMesh )
+  {
+    if ( !m_fUseLod )
+    {
+      return nullptr;
+    }
+    // Drawing the cache rebuilds it whenever the mesh's revision moves on
+    std::shared_ptr< MeshLodCache >& pLodCache = m_lodCaches[pMesh];
+    if ( !pLodCache )
+    {
+      pLodCache = std::make_shared< MeshLodCache >( *pMesh );
+    }
+    return pLodCache;
+  }
+
 public:
   ViewportManager( const Rect<int>& rect );
 
@@ -32,12 +51,15 @@ public:
   void addViewport( INotifiable& listener ); //Handle sizing automatically
 
   Rect<int> getViewportRect() const throw();
+  // Off by default. With LOD on, meshes registered afterwards are added to the
+  // scene by their viewport, so callers must not add their own nodes for them
+  void setUseLod( bool fUseLod ) throw() { m_fUseLod = fUseLod; }
   int getSelectedViewport() const throw();
   void selectViewport( int index ) throw();
 
   template< class T, class U > void registerMeshToViewport(Mesh<T, U>* pMesh, int viewportIndex, const Matrix& worldTransformationMatrix) throw()
   {
-    m_pViewports[viewportIndex]->registerMesh(pMesh, worldTransformationMatrix);
+    m_pViewports[viewportIndex]->registerMesh(pMesh, worldTransformationMatrix, getLodCache(pMesh));
   }
 
   template< class T, class U > void registerMeshToViewport(Mesh<T, U>* pMesh, const Matrix& worldTransformationMatrix) throw()
@@ -48,6 +70,11 @@ public:
   template< class T, class U > void unregisterMeshFromViewport( Mesh<T,U>* pMesh, int viewportIndex ) throw()
   {
     m_pViewports[viewportIndex]->unregisterMesh(pMesh);
+    auto lodCacheIter = m_lodCaches.find(pMesh);
+    if (lodCacheIter != m_lodCaches.end() && lodCacheIter->second.use_count() == 1)
+    {
+      m_lodCaches.erase(lodCacheIter);
+    }
   }
 
   template< class T, class U > void unregisterMeshFromViewport( Mesh<T,U>* pMesh ) throw()
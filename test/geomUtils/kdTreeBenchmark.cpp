@@ -0,0 +1,99 @@
+// Timings of KdTree construction and queries against linear scans over
+// 1M, 10M and 50M uniform random points. Sizes in millions may be given on
+// the command line instead
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "geomUtils/kdTree.h"
+
+namespace {
+typedef Point<float, 3> Point3;
+const size_t c_numTreeQueries = 100000;
+const size_t c_numScanQueries = 20;
+
+double elapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+void run(size_t numPoints) {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(0, 1);
+  std::vector<Point3> points(numPoints);
+  for (Point3& point : points) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      point[axis] = distribution(generator);
+    }
+  }
+  std::vector<Point3> queries(c_numTreeQueries);
+  for (Point3& query : queries) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      query[axis] = distribution(generator);
+    }
+  }
+  std::printf("%zu points\n", numPoints);
+
+  auto start = std::chrono::steady_clock::now();
+  KdTree<float, 3> tree(points);
+  std::printf("  %-36s %10.1f ms\n", "build", elapsedMilliseconds(start));
+
+  std::vector<KdTree<float, 3>::Neighbour> neighbours;
+  for (size_t k : {size_t(1), size_t(10)}) {
+    start = std::chrono::steady_clock::now();
+    tree.kNearest(queries, k, neighbours);
+    char name[64];
+    std::snprintf(name, sizeof(name), "k = %zu, tree, batched", k);
+    std::printf("  %-36s %10.3f us/query\n", name,
+                1000 * elapsedMilliseconds(start) / c_numTreeQueries);
+  }
+
+  std::vector<std::vector<KdTree<float, 3>::Neighbour>> withinRadius;
+  start = std::chrono::steady_clock::now();
+  tree.radiusSearch(queries, 0.01f, withinRadius);
+  size_t numFound = 0;
+  for (const std::vector<KdTree<float, 3>::Neighbour>& found : withinRadius) {
+    numFound += found.size();
+  }
+  std::printf("  %-36s %10.3f us/query  (%.1f found)\n",
+              "radius 0.01, tree, batched",
+              1000 * elapsedMilliseconds(start) / c_numTreeQueries,
+              double(numFound) / c_numTreeQueries);
+
+  start = std::chrono::steady_clock::now();
+  size_t checksum = 0;
+  for (size_t query = 0; query < c_numScanQueries; ++query) {
+    size_t best = 0;
+    float bestDistance2 = points[0].distance2(queries[query]);
+    for (size_t i = 1; i < numPoints; ++i) {
+      float distance2 = points[i].distance2(queries[query]);
+      if (distance2 < bestDistance2) {
+        best = i;
+        bestDistance2 = distance2;
+      }
+    }
+    checksum += best == tree.nearest(queries[query]).index ? 1 : 0;
+  }
+  std::printf("  %-36s %10.3f us/query  (%zu/%zu agree)\n",
+              "k = 1, linear scan",
+              1000 * elapsedMilliseconds(start) / c_numScanQueries, checksum,
+              c_numScanQueries);
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<size_t> millions = {1, 10, 50};
+  if (argc > 1) {
+    millions.clear();
+    for (int arg = 1; arg < argc; ++arg) {
+      millions.push_back(std::strtoul(argv[arg], nullptr, 10));
+    }
+  }
+  for (size_t size : millions) {
+    run(size * 1000000);
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "geomUtils/kdTree.h"
+
+class KdTreeTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> distribution(-10, 10);
+    for (int i = 0; i < 20000; ++i) {
+      m_points.push_back(Point<float, 3>(
+          {distribution(generator), distribution(generator),
+           distribution(generator)}));
+    }
+    // Duplicates, so that ties are exercised
+    m_points.push_back(m_points[100]);
+    m_points.push_back(m_points[100]);
+    for (int i = 0; i < 200; ++i) {
+      m_queries.push_back(Point<float, 3>(
+          {distribution(generator), distribution(generator),
+           distribution(generator)}));
+    }
+    m_queries.push_back(m_points[100]);
+    m_tree = KdTree<float, 3>(m_points);
+  }
+  virtual void TearDown() {}
+
+  // Indices of the k closest points by linear scan, ties to the lower index
+  std::vector<size_t> bruteForce(const Point<float, 3>& query, size_t k) {
+    std::vector<size_t> indices(m_points.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+      indices[i] = i;
+    }
+    std::sort(indices.begin(), indices.end(), [&](size_t a, size_t b) {
+      float distanceA = m_points[a].distance2(query);
+      float distanceB = m_points[b].distance2(query);
+      return distanceA < distanceB || (distanceA == distanceB && a < b);
+    });
+    indices.resize(k);
+    return indices;
+  }
+
+  std::vector<Point<float, 3>> m_points;
+  std::vector<Point<float, 3>> m_queries;
+  KdTree<float, 3> m_tree;
+};
+
+TEST_F(KdTreeTest, kNearest) {
+  ASSERT_EQ(m_tree.size(), m_points.size()) << "Size differs from input";
+  std::vector<KdTree<float, 3>::Neighbour> neighbours;
+  for (const Point<float, 3>& query : m_queries) {
+    m_tree.kNearest(query, 10, neighbours);
+    std::vector<size_t> expected = bruteForce(query, 10);
+    ASSERT_EQ(neighbours.size(), 10u) << "Wrong number of neighbours";
+    for (size_t j = 0; j < expected.size(); ++j) {
+      ASSERT_EQ(neighbours[j].index, expected[j]) << "Neighbour " << j;
+      ASSERT_EQ(neighbours[j].distance2, m_points[expected[j]].distance2(query))
+          << "Distance of neighbour " << j;
+    }
+  }
+  ASSERT_EQ(m_tree.nearest(m_points[100]).index, 100u)
+      << "Ties go to the lower index";
+  m_tree.kNearest(m_queries[0], 100000, neighbours);
+  ASSERT_EQ(neighbours.size(), m_points.size()) << "k is not clamped";
+}
+
+TEST_F(KdTreeTest, radiusSearch) {
+  std::vector<KdTree<float, 3>::Neighbour> neighbours;
+  for (const Point<float, 3>& query : m_queries) {
+    m_tree.radiusSearch(query, 1.5f, neighbours);
+    std::vector<size_t> found;
+    for (const KdTree<float, 3>::Neighbour& neighbour : neighbours) {
+      found.push_back(neighbour.index);
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<size_t> expected;
+    for (size_t i = 0; i < m_points.size(); ++i) {
+      if (m_points[i].distance2(query) <= 1.5f * 1.5f) {
+        expected.push_back(i);
+      }
+    }
+    ASSERT_EQ(found, expected) << "Radius search differs from linear scan";
+  }
+}
+
+TEST_F(KdTreeTest, batches) {
+  std::vector<KdTree<float, 3>::Neighbour> batch;
+  m_tree.kNearest(m_queries, 5, batch);
+  ASSERT_EQ(batch.size(), 5 * m_queries.size()) << "Batch size is wrong";
+  std::vector<KdTree<float, 3>::Neighbour> single;
+  std::vector<std::vector<KdTree<float, 3>::Neighbour>> radiusBatch;
+  m_tree.radiusSearch(m_queries, 1.0f, radiusBatch);
+  for (size_t query = 0; query < m_queries.size(); ++query) {
+    m_tree.kNearest(m_queries[query], 5, single);
+    for (size_t j = 0; j < 5; ++j) {
+      ASSERT_EQ(batch[query * 5 + j].index, single[j].index)
+          << "Batch differs for query " << query;
+    }
+    m_tree.radiusSearch(m_queries[query], 1.0f, single);
+    ASSERT_EQ(radiusBatch[query].size(), single.size())
+        << "Batch differs for query " << query;
+  }
+}
+
+TEST_F(KdTreeTest, otherDimensions) {
+  std::vector<Point<double, 1>> line;
+  for (int i = 0; i < 100; ++i) {
+    line.push_back(Point<double, 1>(std::array<double, 1>{{double(i)}}));
+  }
+  KdTree<double, 1> lineTree(line);
+  Point<double, 1> query(std::array<double, 1>{{41.4}});
+  ASSERT_EQ(lineTree.nearest(query).index, 41u)
+      << "1D nearest failed";
+
+  std::vector<Point<float, 5>> points(3, Point<float, 5>({1, 2, 3, 4, 5}));
+  points[1][4] = 0;
+  KdTree<float, 5> tree(points);
+  ASSERT_EQ(tree.nearest(Point<float, 5>({1, 2, 3, 4, 0})).index, 1u)
+      << "5D nearest failed";
+  KdTree<float, 2> emptyTree((std::vector<Point<float, 2>>()));
+  ASSERT_TRUE(emptyTree.empty()) << "Empty tree is not empty";
+}
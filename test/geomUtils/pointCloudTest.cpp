@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "geomUtils/pointCloud.h"
+
+class PointCloudTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {
+    // A 40 x 40 x 40 grid, large enough to be split into several blocks
+    for (int x = 0; x < 40; ++x) {
+      for (int y = 0; y < 40; ++y) {
+        for (int z = 0; z < 40; ++z) {
+          m_points.push_back(Point<float, 3>({float(x), float(y), float(z)}));
+        }
+      }
+    }
+    m_cloud = PointCloud<float, 3>(m_points);
+  }
+  virtual void TearDown() {}
+
+  std::vector<Point<float, 3>> m_points;
+  PointCloud<float, 3> m_cloud;
+};
+
+TEST_F(PointCloudTest, layout) {
+  ASSERT_EQ(m_cloud.size(), m_points.size()) << "Size differs from input";
+  ASSERT_EQ(m_cloud.point(1234).distance2(m_points[1234]), 0.0f)
+      << "Point round trip failed";
+  ASSERT_EQ(m_cloud.coordinates(2)[41], 1.0f) << "SoA layout is wrong";
+}
+
+TEST_F(PointCloudTest, boundingBoxAndCentroid) {
+  std::pair<Point<float, 3>, Point<float, 3>> box = m_cloud.boundingBox();
+  ASSERT_EQ(box.first[0], 0.0f) << "Bounding box low corner failed";
+  ASSERT_EQ(box.second[2], 39.0f) << "Bounding box high corner failed";
+  Point<float, 3> centroid = m_cloud.centroid();
+  ASSERT_FLOAT_EQ(centroid[1], 19.5f) << "Centroid failed";
+  Point<float, 3> average(m_points);
+  ASSERT_FLOAT_EQ(average[1], 19.5f)
+      << "Point centroid constructor disagrees";
+}
+
+TEST_F(PointCloudTest, transform) {
+  // Swap x and y, then translate by (1, 2, 3)
+  const float matrix[4][4] = {
+      {0, 1, 0, 1}, {1, 0, 0, 2}, {0, 0, 1, 3}, {0, 0, 0, 1}};
+  m_cloud.transform(matrix);
+  Point<float, 3> point = m_cloud.point(40 * 40 * 5 + 40 * 7 + 9);
+  ASSERT_EQ(point[0], 8.0f) << "Transformed x failed";
+  ASSERT_EQ(point[1], 7.0f) << "Transformed y failed";
+  ASSERT_EQ(point[2], 12.0f) << "Transformed z failed";
+}
+
+TEST_F(PointCloudTest, kClosest) {
+  Point<float, 3> query({10.1f, 20, 30});
+  std::vector<size_t> closest = m_cloud.kClosest(query, 4);
+  ASSERT_EQ(closest.size(), 4u) << "Wrong number of neighbours";
+  ASSERT_EQ(closest[0], size_t(40 * 40 * 10 + 40 * 20 + 30))
+      << "Nearest point failed";
+  ASSERT_EQ(closest[1], size_t(40 * 40 * 11 + 40 * 20 + 30))
+      << "Second nearest point failed";
+  // Four points lie at the next distance; the two lowest indices are kept
+  ASSERT_EQ(closest[2], size_t(40 * 40 * 10 + 40 * 19 + 30))
+      << "Ties must go to the lower index";
+  ASSERT_EQ(closest[3], size_t(40 * 40 * 10 + 40 * 20 + 29))
+      << "Ties must go to the lower index";
+  std::vector<float> distances2;
+  m_cloud.distance2(query, distances2);
+  ASSERT_NEAR(distances2[closest[0]], 0.01f, 1e-6f) << "distance2 failed";
+  ASSERT_EQ(m_cloud.kClosest(query, 100000).size(), m_cloud.size())
+      << "k beyond the size returns everything";
+}
@@ -1,13 +1,117 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <vector>
+
 #include "geomUtils/polyline.h"
 
 class PolylineTest : public ::testing::Test {
-  protected:
-    virtual void SetUp() {}
-    virtual void TearDown() {}
+ protected:
+  virtual void SetUp() {
+    // An L shape: 3 along x, then 4 along y
+    m_corner = Polyline<float, 2>(std::vector<Point<float, 2>>{
+        Point<float, 2>({0, 0}), Point<float, 2>({1, 0}),
+        Point<float, 2>({3, 0}), Point<float, 2>({3, 4})});
+    // A noisy sine wave, long enough to span several blocks
+    for (int i = 0; i < 2000; ++i) {
+      float x = i * 0.01f;
+      float noise = (i % 7 - 3) * 0.001f;
+      m_wave.push_back(Point<float, 2>({x, std::sin(x) + noise}));
+    }
+  }
+  virtual void TearDown() {}
+
+  Polyline<float, 2> m_corner;
+  Polyline<float, 2> m_wave;
 };
 
 TEST_F(PolylineTest, size) {
-  Polyline polyline;
+  Polyline<float, 2> polyline;
+  ASSERT_TRUE(polyline.empty()) << "Default polyline is not empty";
+  ASSERT_EQ(polyline.numSegments(), 0u) << "Empty polyline has segments";
+  ASSERT_EQ(m_corner.size(), 4u) << "Size differs from input";
+  ASSERT_EQ(m_corner.coordinates(1)[3], 4.0f) << "SoA layout is wrong";
+}
+
+TEST_F(PolylineTest, lengths) {
+  ASSERT_FLOAT_EQ(m_corner.length(), 7.0f) << "Length failed";
+  std::vector<float> arcLengths;
+  m_corner.arcLengths(arcLengths);
+  ASSERT_EQ(arcLengths.size(), 4u) << "One arc length per vertex";
+  ASSERT_EQ(arcLengths[0], 0.0f) << "Arc lengths start at zero";
+  ASSERT_FLOAT_EQ(arcLengths[2], 3.0f) << "Arc length failed";
+  ASSERT_FLOAT_EQ(arcLengths[3], 7.0f) << "Arc length failed";
+}
+
+TEST_F(PolylineTest, resample) {
+  Polyline<float, 2> resampled = m_corner.resample(2.0f);
+  ASSERT_EQ(resampled.size(), 5u) << "Samples at 0, 2, 4, 6 and the end";
+  ASSERT_FLOAT_EQ(resampled.point(1)[0], 2.0f) << "Sample 1 failed";
+  ASSERT_FLOAT_EQ(resampled.point(2)[0], 3.0f) << "Sample 2 failed";
+  ASSERT_FLOAT_EQ(resampled.point(2)[1], 1.0f) << "Sample 2 failed";
+  ASSERT_FLOAT_EQ(resampled.point(4)[1], 4.0f) << "End vertex is kept";
+  ASSERT_EQ(m_corner.resample(3.5f).size(), 3u)
+      << "The end vertex is not repeated when a sample falls on it";
+}
+
+TEST_F(PolylineTest, nearestPoint) {
+  Polyline<float, 2>::Projection projection =
+      m_corner.project(Point<float, 2>({2, 1}));
+  ASSERT_EQ(projection.segment, 1u) << "Nearest segment failed";
+  ASSERT_FLOAT_EQ(projection.t, 0.5f) << "Nearest parameter failed";
+  ASSERT_FLOAT_EQ(projection.distance2, 1.0f) << "Nearest distance failed";
+  Point<float, 2> nearest = m_corner.nearestPoint(Point<float, 2>({5, 3}));
+  ASSERT_FLOAT_EQ(nearest[0], 3.0f) << "Nearest point failed";
+  ASSERT_FLOAT_EQ(nearest[1], 3.0f) << "Nearest point failed";
+  ASSERT_EQ(m_corner.project(Point<float, 2>({-1, -1})).t, 0.0f)
+      << "Projection is not clamped to the segment";
+
+  size_t vertex = 1234;
+  projection = m_wave.project(m_wave.point(vertex));
+  ASSERT_EQ(projection.distance2, 0.0f) << "Vertex is not on the polyline";
+  ASSERT_EQ(projection.segment + (projection.t == 1 ? 1 : 0), vertex)
+      << "Wrong segment found in a later block";
+}
+
+TEST_F(PolylineTest, douglasPeucker) {
+  Polyline<float, 2> simplified = m_corner.simplifyDouglasPeucker(0.1f);
+  ASSERT_EQ(simplified.size(), 3u) << "Collinear vertex is not removed";
+  ASSERT_EQ(simplified.point(1)[0], 3.0f) << "Corner is not kept";
+
+  simplified = m_wave.simplifyDouglasPeucker(0.01f);
+  ASSERT_LT(simplified.size(), m_wave.size() / 10) << "Too little removed";
+  const float tolerance2 = 0.0101f * 0.0101f;
+  for (size_t i = 0; i < m_wave.size(); i += 37) {
+    ASSERT_LE(simplified.project(m_wave.point(i)).distance2, tolerance2)
+        << "Vertex " << i << " is farther than the tolerance";
+  }
+}
+
+TEST_F(PolylineTest, visvalingam) {
+  Polyline<float, 2> simplified = m_corner.simplifyVisvalingam(0.1f);
+  ASSERT_EQ(simplified.size(), 3u) << "Zero area vertex is not removed";
+  ASSERT_EQ(simplified.point(1)[1], 0.0f) << "Corner is not kept";
+  ASSERT_EQ(m_corner.simplifyVisvalingam(7.0f).size(), 2u)
+      << "Large threshold keeps only the ends";
+
+  simplified = m_wave.simplifyVisvalingam(0.001f);
+  ASSERT_LT(simplified.size(), m_wave.size() / 10) << "Too little removed";
+  ASSERT_EQ(simplified.point(0)[0], 0.0f) << "First vertex is not kept";
+}
+
+TEST_F(PolylineTest, batches) {
+  std::vector<Polyline<float, 2>> polylines(100, m_wave);
+  polylines[50] = m_corner;
+  std::vector<Polyline<float, 2>> simplified =
+      simplifyDouglasPeucker(polylines, 0.01f);
+  ASSERT_EQ(simplified.size(), polylines.size()) << "Batch size changed";
+  ASSERT_EQ(simplified[99].size(),
+            m_wave.simplifyDouglasPeucker(0.01f).size())
+      << "Batch differs from a single polyline";
+  ASSERT_EQ(simplified[50].size(), 3u) << "Batch order changed";
+  ASSERT_EQ(simplifyVisvalingam(polylines, 0.001f)[0].size(),
+            m_wave.simplifyVisvalingam(0.001f).size())
+      << "Batch differs from a single polyline";
+  ASSERT_EQ(resample(polylines, 0.5f)[50].size(), 15u)
+      << "Batch resampling failed";
 }
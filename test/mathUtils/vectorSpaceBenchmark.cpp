@@ -0,0 +1,164 @@
+// Timings of linear combinations through the vectorSpace functions and
+// through expression templates. Prints one line per variant
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "geomUtils/point.h"
+#include "geomUtils/vector.h"
+
+namespace {
+typedef Point<float, 3> Point3;
+const size_t c_numPoints = 1 << 20;
+const int c_numRepetitions = 20;
+const size_t c_numCombined = 8;
+
+template <typename Function>
+void time(const char* name, Function function) {
+  auto start = std::chrono::steady_clock::now();
+  float checksum = 0;
+  for (int repetition = 0; repetition < c_numRepetitions; ++repetition) {
+    checksum += function();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::printf("%-44s %8.2f ms/pass  (checksum %g)\n", name,
+              elapsed.count() / c_numRepetitions, checksum);
+}
+}  // namespace
+
+int main() {
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> distribution(-1, 1);
+  std::vector<Point3> p(c_numPoints), q(c_numPoints), r(c_numPoints);
+  for (size_t i = 0; i < c_numPoints; ++i) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      p[i][axis] = distribution(generator);
+      q[i][axis] = distribution(generator);
+      r[i][axis] = distribution(generator);
+    }
+  }
+  std::vector<Point3> out(c_numPoints);
+  const float a = 0.5f, b = 1.5f, c = 2.0f;
+
+  std::printf("a * P + b * Q - c * R over %zu points\n", c_numPoints);
+  time("bilinearCombination, iterator version", [&]() {
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      out[i] = bilinearCombination<Point3>(
+          bilinearCombination<Point3>(p[i], q[i], a, b), r[i], 1.0f, -c);
+    }
+    return out[c_numPoints / 2][0];
+  });
+  time("bilinearCombination, fixed N", [&]() {
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      out[i] = bilinearCombination<Point3, Point3, Point3, 3>(
+          bilinearCombination<Point3, Point3, Point3, 3>(p[i], q[i], a, b),
+          r[i], 1.0f, -c);
+    }
+    return out[c_numPoints / 2][0];
+  });
+  time("expression template", [&]() {
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      out[i] = a * p[i] + b * q[i] - c * r[i];
+    }
+    return out[c_numPoints / 2][0];
+  });
+
+  std::printf("\nWeighted sums of %zu points, %zu times\n", c_numCombined,
+              c_numPoints / c_numCombined);
+  std::vector<float> weights(c_numCombined, 1.0f / c_numCombined);
+  std::vector<std::vector<Point3>> groups;
+  for (size_t first = 0; first + c_numCombined <= c_numPoints;
+       first += c_numCombined) {
+    groups.push_back(std::vector<Point3>(p.begin() + first,
+                                         p.begin() + first + c_numCombined));
+  }
+  time("bilinearCombination per input", [&]() {
+    float sum = 0;
+    for (const std::vector<Point3>& points : groups) {
+      Point3 combination;
+      for (size_t i = 0; i < c_numCombined; ++i) {
+        combination = bilinearCombination<Point3, Point3, Point3, 3>(
+            combination, points[i], 1.0f, weights[i]);
+      }
+      sum += combination[0];
+    }
+    return sum;
+  });
+  time("multilinearCombination, fixed N", [&]() {
+    float sum = 0;
+    for (const std::vector<Point3>& points : groups) {
+      Point3 combination =
+          multilinearCombination<Point3, std::vector<Point3>,
+                                 std::vector<float>, 3>(points, weights);
+      sum += combination[0];
+    }
+    return sum;
+  });
+  time("expression template +=", [&]() {
+    float sum = 0;
+    for (const std::vector<Point3>& points : groups) {
+      Point3 combination;
+      for (size_t i = 0; i < c_numCombined; ++i) {
+        combination += weights[i] * points[i];
+      }
+      sum += combination[0];
+    }
+    return sum;
+  });
+
+  std::printf("\nSmall operations over %zu pairs\n", c_numPoints);
+  std::vector<std::array<float, 3>> plainP(c_numPoints), plainQ(c_numPoints);
+  for (size_t i = 0; i < c_numPoints; ++i) {
+    for (size_t axis = 0; axis < 3; ++axis) {
+      plainP[i][axis] = p[i][axis];
+      plainQ[i][axis] = q[i][axis];
+    }
+  }
+  std::vector<Vector<float, 3>> u(c_numPoints), v(c_numPoints);
+  for (size_t i = 0; i < c_numPoints; ++i) {
+    u[i] = Vector<float, 3>(plainP[i]);
+    v[i] = Vector<float, 3>(plainQ[i]);
+  }
+  time("distance2, scalar std::array", [&]() {
+    float sum = 0;
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      float dx = plainP[i][0] - plainQ[i][0];
+      float dy = plainP[i][1] - plainQ[i][1];
+      float dz = plainP[i][2] - plainQ[i][2];
+      sum += dx * dx + dy * dy + dz * dz;
+    }
+    return sum;
+  });
+  time("distance2, Point<float, 3>", [&]() {
+    float sum = 0;
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      sum += p[i].distance2(q[i]);
+    }
+    return sum;
+  });
+  time("normalized cross, scalar std::array", [&]() {
+    float sum = 0;
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      const std::array<float, 3>& a = plainP[i];
+      const std::array<float, 3>& b = plainQ[i];
+      float x = a[1] * b[2] - a[2] * b[1];
+      float y = a[2] * b[0] - a[0] * b[2];
+      float z = a[0] * b[1] - a[1] * b[0];
+      float norm = std::sqrt(x * x + y * y + z * z);
+      sum += norm > 0.000001f ? x * (1 / norm) : x;
+    }
+    return sum;
+  });
+  time("normalized cross, Vector<float, 3>", [&]() {
+    float sum = 0;
+    for (size_t i = 0; i < c_numPoints; ++i) {
+      sum += u[i].cross(v[i]).normalize()[0];
+    }
+    return sum;
+  });
+  return 0;
+}
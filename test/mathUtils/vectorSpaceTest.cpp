@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+#include "geomUtils/point.h"
+#include "geomUtils/vector.h"
+
+class VectorSpaceTest : public ::testing::Test {
+ protected:
+  virtual void SetUp() {}
+  virtual void TearDown() {}
+};
+
+TEST_F(VectorSpaceTest, expressionMatchesFunctions) {
+  Point<float, 3> p({1, 2, 3});
+  Point<float, 3> q({-4, 5, 0.5f});
+  Point<float, 3> r({2, -1, 7});
+  Point<float, 3> combination = 2.0f * p + 0.5f * q - 3.0f * r;
+  Point<float, 3> expected = bilinearCombination<Point<float, 3>,
+      Point<float, 3>, Point<float, 3>, 3>(
+      bilinearCombination<Point<float, 3>, Point<float, 3>, Point<float, 3>,
+                          3>(p, q, 2.0f, 0.5f),
+      r, 1.0f, -3.0f);
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_FLOAT_EQ(combination[i], expected[i]) << "Coordinate " << i;
+  }
+}
+
+TEST_F(VectorSpaceTest, aliasing) {
+  Point<double, 4> p({1, 2, 3, 4});
+  Point<double, 4> q({4, 3, 2, 1});
+  p = 2.0 * p - q;
+  ASSERT_EQ(p[0], -2.0) << "Assigning an expression of itself failed";
+  ASSERT_EQ(p[3], 7.0) << "Assigning an expression of itself failed";
+  p += q;
+  ASSERT_EQ(p[1], 4.0) << "Adding an expression in place failed";
+}
+
+TEST_F(VectorSpaceTest, vectors) {
+  Point<float, 3> p({1, 1, 1});
+  Point<float, 3> q({4, 5, 1});
+  Vector<float, 3> v(p, q);
+  ASSERT_EQ(v.norm(), 5.0f) << "Vector between points is q - p";
+  ASSERT_EQ((Point<float, 3>(p, 0.5f, v)[1]), 3.0f)
+      << "Point plus scaled vector failed";
+  Vector<float, 3> w = v - 2.0f * v;
+  ASSERT_EQ(w.dot(v), -25.0f) << "Dot product of expression result failed";
+}
+
+TEST_F(VectorSpaceTest, multilinearCombination) {
+  std::vector<Point<float, 2>> points;
+  points.push_back(Point<float, 2>({1, 0}));
+  points.push_back(Point<float, 2>({0, 2}));
+  points.push_back(Point<float, 2>({3, 3}));
+  std::vector<float> weights = {1, 2, -1};
+  Point<float, 2> fixedSize =
+      multilinearCombination<Point<float, 2>, std::vector<Point<float, 2>>,
+                             std::vector<float>, 2>(points, weights);
+  Point<float, 2> generic =
+      multilinearCombination<Point<float, 2>>(points, weights);
+  ASSERT_EQ(fixedSize[0], -2.0f) << "Fixed size combination failed";
+  ASSERT_EQ(fixedSize[1], 1.0f) << "Fixed size combination failed";
+  ASSERT_EQ(generic[0], fixedSize[0]) << "Generic combination differs";
+  ASSERT_EQ(generic[1], fixedSize[1]) << "Generic combination differs";
+}
+
+TEST_F(VectorSpaceTest, paddedFloatVectors) {
+  static_assert(sizeof(Vector<float, 3>) == 16, "Float 3-vectors are padded");
+  static_assert(alignof(Point<float, 3>) == 16, "Float 3-vectors are aligned");
+  Vector<float, 3> x({1, 0, 0});
+  Vector<float, 3> y({0, 1, 0});
+  Vector<float, 3> z = x.cross(y);
+  ASSERT_EQ(z[2], 1.0f) << "Cross product failed";
+  ASSERT_EQ(z[0], 0.0f) << "Cross product failed";
+  Vector<float, 3> v({3, 4, 12});
+  ASSERT_EQ(v.norm(), 13.0f) << "Norm failed";
+  ASSERT_FLOAT_EQ(v.normalize().sqnorm(), 1.0f) << "Normalize failed";
+  ASSERT_EQ(v.data()[3], 0.0f) << "Padding lane must stay zero";
+  Point<float, 3> p({1, 2, 3});
+  Point<float, 3> q({3, 2, 1});
+  Point<float, 3> combination = 2.0f * p - q;
+  ASSERT_EQ(combination.data()[3], 0.0f) << "Padding lane must stay zero";
+  ASSERT_EQ((Point<float, 3>(p, 0.25f, q)[0]), 1.5f) << "Lerp failed";
+  ASSERT_EQ(p.distance2(q), 8.0f) << "Distance failed";
+  ASSERT_EQ(std::distance(p.cbegin(), p.cend()), 3) << "Padding is iterated";
+
+  Vector<float, 4> a({1, 2, 3, 4});
+  Vector<float, 4> b({4, 3, 2, 1});
+  ASSERT_EQ(a.dot(b), 20.0f) << "4D dot product failed";
+  Vector<double, 3> c({1, 2, 3});
+  ASSERT_EQ(c.cross(Vector<double, 3>({0, 0, 1}))[0], 2.0)
+      << "Generic cross product failed";
+}
+
+namespace {
+typedef Vector<float, 3> Vector3;
+
+// Normals of the faces of a cube, built at compile time
+constexpr std::array<Vector3, 6> c_cubeNormals = {
+    {Vector3::axis(0), Vector3::axis(1), Vector3::axis(2),
+     -1.0f * Vector3::axis(0), -1.0f * Vector3::axis(1),
+     -1.0f * Vector3::axis(2)}};
+
+constexpr Point<float, 3> c_origin;
+constexpr Point<float, 3> c_corner({1, 2, 3});
+constexpr Point<float, 3> c_middle(c_origin, c_corner);
+constexpr Point<float, 3> c_combination = 2.0f * c_corner - c_middle;
+constexpr std::array<double, 2> c_array = {{1, 2}};
+constexpr std::array<double, 2> c_scaledArray =
+    scale<std::array<double, 2>, std::array<double, 2>, 2>(c_array, 3);
+}  // namespace
+
+TEST_F(VectorSpaceTest, constantExpressions) {
+  static_assert(c_middle[1] == 1.0f, "Constant midpoint failed");
+  static_assert(c_combination[2] == 4.5f, "Constant expression failed");
+  static_assert(c_corner.distance2(c_origin) == 14.0f,
+                "Constant distance failed");
+  static_assert(c_cubeNormals[0].cross(c_cubeNormals[1])[2] == 1.0f,
+                "Constant cross product failed");
+  static_assert(c_cubeNormals[5].dot(c_cubeNormals[2]) == -1.0f,
+                "Constant dot product failed");
+  static_assert(Vector3(c_origin, c_corner).sqnorm() == 14.0f,
+                "Constant vector between points failed");
+  static_assert(c_scaledArray[1] == 6.0, "Constant scale failed");
+  static_assert(innerProduct(c_corner, c_corner) == 14.0f,
+                "Constant inner product failed");
+
+  // The same operations at run time take the SSE kernels
+  Vector3 x = c_cubeNormals[0];
+  Vector3 y = c_cubeNormals[1];
+  ASSERT_EQ(x.cross(y)[2], c_cubeNormals[0].cross(c_cubeNormals[1])[2])
+      << "Run time and compile time cross products differ";
+  ASSERT_EQ(x.cross(y).data()[3], 0.0f) << "Padding lane must stay zero";
+}
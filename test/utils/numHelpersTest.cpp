@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "utils/numHelpers.h"
+
+TEST(NumHelpersTest, quantizeValues) {
+  std::vector<float> values = {-1.0f, -0.5f, 0.0f, 1.0f, 2.0f,
+                               std::numeric_limits<float>::quiet_NaN()};
+  std::vector<uint8_t> codes(values.size());
+  quantizeValues(values.data(), values.size(), -0.5f, 1.0f, 8, codes.data());
+  ASSERT_EQ(codes[0], 0) << "Values below the range do not clamp";
+  ASSERT_EQ(codes[1], 0) << "Range start is not code 0";
+  ASSERT_EQ(codes[2], 85) << "Value does not round to the nearest level";
+  ASSERT_EQ(codes[3], 255) << "Range end is not the largest code";
+  ASSERT_EQ(codes[4], 255) << "Values above the range do not clamp";
+  ASSERT_EQ(codes[5], 0) << "NaN does not clamp to the range start";
+
+  std::vector<uint16_t> degenerate(2);
+  quantizeValues(values.data(), 2, 1.0f, 1.0f, 16, degenerate.data());
+  ASSERT_EQ(degenerate[1], 0) << "Empty range does not give code 0";
+}
+
+TEST(NumHelpersTest, roundTrip) {
+  // Long enough to be split across threads
+  const size_t count = 300000;
+  std::vector<float> values(count);
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = std::sin(i * 0.001f) * 3.0f;
+  }
+  for (int numBits : c_quantizationBitDepths) {
+    std::vector<uint16_t> codes(count);
+    std::vector<float> dequantized(count);
+    quantizeValues(values.data(), count, -3.0f, 3.0f, numBits, codes.data());
+    dequantizeValues(codes.data(), count, -3.0f, 3.0f, numBits,
+                     dequantized.data());
+    float maxError = quantizationStep(-3.0f, 3.0f, numBits) / 2;
+    for (size_t i = 0; i < count; i += 7) {
+      ASSERT_LT(codes[i], 1 << numBits) << "Code out of range";
+      // Up to float rounding
+      ASSERT_LE(std::fabs(dequantized[i] - values[i]), maxError + 1e-6f)
+          << "Error above half a step at " << numBits << " bits";
+    }
+  }
+}
+
+TEST(NumHelpersTest, pointSets) {
+  std::vector<float> x = {0, 1, 2};
+  std::vector<float> y = {10, 15, 20};
+  std::vector<uint16_t> codesX(3);
+  std::vector<uint16_t> codesY(3);
+  std::array<float, 2> minValues = {{0, 10}};
+  std::array<float, 2> maxValues = {{2, 20}};
+  quantizeValues<float, uint16_t, 2>({{x.data(), y.data()}}, 3, minValues,
+                                     maxValues, 10,
+                                     {{codesX.data(), codesY.data()}});
+  ASSERT_EQ(codesX[2], 1023) << "Axis range is not applied";
+  ASSERT_EQ(codesY[0], 0) << "Axis range is not applied";
+  ASSERT_EQ(codesY[1], 512) << "Axis range is not applied";
+
+  std::vector<float> outY(3);
+  dequantizeValues<uint16_t, float, 2>({{codesX.data(), codesY.data()}}, 3,
+                                       minValues, maxValues, 10,
+                                       {{x.data(), outY.data()}});
+  ASSERT_NEAR(outY[1], 15.0f, quantizationStep(10.0f, 20.0f, 10) / 2)
+      << "Dequantization failed";
+}
+
+TEST(NumHelpersTest, quantizationBits) {
+  ASSERT_EQ(quantizationBits(0.0f, 1.0f, 0.01f), 8) << "8 bits suffice";
+  ASSERT_EQ(quantizationBits(0.0f, 1.0f, 0.001f), 10) << "10 bits suffice";
+  ASSERT_EQ(quantizationBits(0.0f, 1.0f, 0.0002f), 12) << "12 bits suffice";
+  ASSERT_EQ(quantizationBits(0.0f, 1.0f, 0.00001f), 16) << "16 bits suffice";
+  ASSERT_EQ(quantizationBits(0.0f, 1.0f, 0.000001f), 0) << "None suffices";
+  std::array<float, 2> minValues = {{0, 0}};
+  std::array<float, 2> maxValues = {{1, 100}};
+  ASSERT_EQ(quantizationBits(minValues, maxValues, 0.01f), 16)
+      << "The widest axis does not decide";
+}
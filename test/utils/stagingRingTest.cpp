@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+#include "utils/stagingRing.h"
+
+class StagingRingTest : public ::testing::Test {
+ protected:
+  // One frame as updateGeometryVBO streams it: map a region, write it, draw
+  // from it and fence it, then let the simulated GPU move on
+  StagingRing::Allocation runFrame(StagingRing& ring,
+                                   MockStagingBackend& backend,
+                                   size_t frameSize, unsigned char value) {
+    EXPECT_TRUE(ring.beginFrame(frameSize));
+    StagingRing::Allocation allocation = ring.allocate(frameSize);
+    std::memset(allocation.pData, value, frameSize);
+    ring.fenceCurrentRegion();
+    backend.advanceFrame();
+    return allocation;
+  }
+};
+
+TEST_F(StagingRingTest, wrapsAroundRegions) {
+  MockStagingBackend* pBackend = new MockStagingBackend(2);
+  StagingRing ring{std::unique_ptr<IStagingBackend>(pBackend)};
+  const size_t frameSize = 1000;
+  const size_t regionSize = alignToStagingRing(frameSize);
+
+  for (int frame = 0; frame < 10; ++frame) {
+    StagingRing::Allocation allocation =
+        runFrame(ring, *pBackend, frameSize, (unsigned char)frame);
+    int region = frame % StagingRing::c_numRegions;
+    ASSERT_EQ(ring.currentRegion(), region) << "Regions are not used in turn";
+    ASSERT_EQ(allocation.offset, region * regionSize)
+        << "Frame does not start at its region";
+    ASSERT_EQ(pBackend->storage()[region * regionSize], frame)
+        << "Frame was not written to its region";
+  }
+  ASSERT_EQ(pBackend->numAllocations(), 1) << "Storage reallocated";
+  int numRegions = StagingRing::c_numRegions;
+  ASSERT_LE(pBackend->numLiveFences(), numRegions)
+      << "Fences of reused regions are not deleted";
+}
+
+TEST_F(StagingRingTest, reusesRegionsWithoutStalling) {
+  // The GPU is two frames behind, so a region's fence has signalled by the
+  // time the ring comes back to it
+  MockStagingBackend* pBackend = new MockStagingBackend(2);
+  StagingRing ring{std::unique_ptr<IStagingBackend>(pBackend)};
+  for (int frame = 0; frame < 30; ++frame) {
+    runFrame(ring, *pBackend, 256, 1);
+  }
+  ASSERT_EQ(ring.numStalledFrames(), 0) << "Ring waited for a signalled fence";
+  ASSERT_EQ(pBackend->numBlockingWaits(), 0) << "Ring blocked on the GPU";
+}
+
+TEST_F(StagingRingTest, waitsForRegionsStillInUse) {
+  // The GPU is further behind than the ring is deep, so the first region is
+  // still being read when the ring comes back to it
+  MockStagingBackend* pBackend = new MockStagingBackend(5);
+  StagingRing ring{std::unique_ptr<IStagingBackend>(pBackend)};
+  for (int frame = 0; frame < StagingRing::c_numRegions; ++frame) {
+    runFrame(ring, *pBackend, 256, 1);
+  }
+  ASSERT_EQ(ring.numStalledFrames(), 0) << "Stalled before wrapping around";
+  runFrame(ring, *pBackend, 256, 1);
+  ASSERT_EQ(ring.numStalledFrames(), 1)
+      << "Reusing an unsignalled region is not counted as a stall";
+  ASSERT_EQ(pBackend->numBlockingWaits(), 1)
+      << "Ring wrote a region whose fence had not signalled";
+
+  // Waiting let the GPU catch up, and every later reuse still waits for its
+  // fence whenever it has not signalled
+  for (int frame = 0; frame < 20; ++frame) {
+    runFrame(ring, *pBackend, 256, 1);
+  }
+  ASSERT_EQ(ring.numStalledFrames(), pBackend->numBlockingWaits())
+      << "Stalls and blocking waits disagree";
+}
+
+TEST_F(StagingRingTest, growsAfterDrainingRegions) {
+  MockStagingBackend* pBackend = new MockStagingBackend(2);
+  StagingRing ring{std::unique_ptr<IStagingBackend>(pBackend)};
+  runFrame(ring, *pBackend, 128, 1);
+  runFrame(ring, *pBackend, 128, 1);
+  runFrame(ring, *pBackend, 4096, 2);
+  ASSERT_EQ(pBackend->numAllocations(), 2) << "Larger frame did not grow";
+  ASSERT_GE(ring.regionSize(), size_t(4096)) << "Region too small for frame";
+  ASSERT_EQ(pBackend->numLiveFences(), 1)
+      << "Fences of the old storage were not waited for";
+  runFrame(ring, *pBackend, 1024, 3);
+  ASSERT_EQ(pBackend->numAllocations(), 2) << "Smaller frame reallocated";
+}
+
+TEST_F(StagingRingTest, reportsMapFailure) {
+  MockStagingBackend* pBackend = new MockStagingBackend(2);
+  StagingRing ring{std::unique_ptr<IStagingBackend>(pBackend)};
+  pBackend->setFailAllocations(true);
+  ASSERT_FALSE(ring.beginFrame(256)) << "Failed mapping not reported";
+  ASSERT_EQ(ring.regionSize(), size_t(0)) << "Failed mapping left a size";
+
+  pBackend->setFailAllocations(false);
+  ASSERT_TRUE(ring.beginFrame(256)) << "Ring does not map again";
+  ASSERT_EQ(ring.currentRegion(), 0) << "Failed frame moved the ring on";
+}